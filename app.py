@@ -11,11 +11,12 @@ st.title(" Vehicle Routing Problem Solver with Real Routes")
 
 st.markdown("""
 This app solves the Vehicle Routing Problem (VRP) using various algorithms:
-- **Brute Force**: Exact solution (only for small problems)
+- **Brute Force**: Exact solution (up to 20 delivery points)
 - **Nearest Neighbor**: Fast heuristic based on greedy selection
 - **Clarke Wright**: Savings-based heuristic
 - **Genetic Algorithm**: Evolutionary metaheuristic
 - **Simulated Annealing**: Probabilistic metaheuristic
+- **Portfolio**: Races the heuristics and metaheuristics within a time budget and keeps the best
 """)
 
 # Input form
@@ -36,8 +37,11 @@ with st.form(key="vrp_form"):
             "Nearest Neighbor", 
             "Clarke Wright", 
             "Genetic Algorithm", 
-            "Simulated Annealing"
+            "Simulated Annealing",
+            "Portfolio (race all)"
         ])
+        time_budget = st.number_input("Portfolio time budget (seconds)", min_value=0.5, max_value=60.0, value=3.0, step=0.5)
+        local_search = st.checkbox("Improve with local search (2-opt, Or-opt, swap*)", value=False)
         
     submit = st.form_submit_button("Solve VRP")
 
@@ -47,11 +51,10 @@ if submit:
         depot = parse_coordinates(depot_str)[0]
         deliveries = parse_coordinates(delivery_str)
         
-        # Validate number of nodes for brute force
-        if algo == "Brute Force" and len(deliveries) > 8:
-            st.warning(f"⚠️ Brute Force algorithm is impractical for {len(deliveries)} nodes. Consider using a different algorithm or reducing the number of delivery points.")
-            if not st.button("Proceed Anyway (may take a long time)"):
-                st.stop()
+        # Validate number of nodes for brute force (exact solver, at most 20 delivery points)
+        if algo == "Brute Force" and len(deliveries) > 20:
+            st.warning(f"⚠️ Brute Force (exact) supports at most 20 delivery points, got {len(deliveries)}. Consider using a different algorithm or reducing the number of delivery points.")
+            st.stop()
         
         # Display coordinates
         with st.expander("📍 Coordinates"):
@@ -70,11 +73,18 @@ if submit:
         
         # Solve VRP
         with st.spinner(f"Solving VRP using {algo} algorithm..."):
-            # Create args for C++ solver
-            with open("num_vehicles.txt", "w") as f:
-                f.write(str(num_vehicles))
-                
-            route_indices = solve_vrp(matrix, algo)
+            race = {}
+            time_limit = time_budget if algo == "Portfolio (race all)" else None
+            route_indices, route_distances = solve_vrp(matrix, algo, num_vehicles, local_search, time_limit=time_limit,
+                                                       with_costs=True, details=race)
+        
+        # Portfolio: which solver won, and how every racer did
+        if race.get("runs"):
+            st.info(f"🏁 Winner: {race['winner']}")
+            with st.expander("🏎️ Portfolio runs"):
+                for run in race["runs"]:
+                    distance = f"{run['distance']/1000:.2f} km" if "distance" in run else run.get("error", "-")
+                    st.write(f"**{run['algorithm']}**: {run['status']} after {run['elapsed_ms']:.0f} ms, {distance}")
         
         # Visualize routes
         st.subheader("🛣️ Route Visualization")
@@ -96,32 +106,8 @@ if submit:
         total_distance = 0
         
         for i, route in enumerate(route_indices):
-            # Calculate distance for this route
-            route_distance = 0
-            coords = [depot] + deliveries
-            for j in range(len(route) - 1):
-                if route[j] == 0:
-                    idx1 = 0  # Depot
-                else:
-                    idx1 = route[j]
-                
-                if route[j+1] == 0:
-                    idx2 = 0  # Depot
-                else:
-                    idx2 = route[j+1]
-                
-                if idx1 == 0 and idx2 == 0:
-                    # Both depot, no distance
-                    continue
-                elif idx1 == 0:
-                    # From depot to delivery
-                    route_distance += matrix[idx2-1][0]
-                elif idx2 == 0:
-                    # From delivery to depot
-                    route_distance += matrix[idx1-1][0]
-                else:
-                    # Between deliveries
-                    route_distance += matrix[idx1-1][idx2]
+            # Distances come back from the solver with the routes
+            route_distance = route_distances[i]
             
             # Convert to km
             route_distance_km = route_distance / 1000
@@ -0,0 +1,181 @@
+#ifndef BRUTE_FORCE_H
+#define BRUTE_FORCE_H
+
+#include "common.h"
+#include "parallel.h"
+
+// Largest instance the exact solver accepts: the route table alone needs
+// 2^N * N ints (80 MB at N = 20)
+const int EXACT_MAX_CUSTOMERS = 20;
+
+// Tuning knobs for bruteForceVRP
+struct ExactParams {
+    int threads = 1;
+};
+
+// Exact solver for VRP (kept under the brute force name used by the app)
+// Minimises total distance over every split of the delivery points into at
+// most numVehicles routes, with the best visiting order inside each route:
+//  1. Held-Karp: best[S][j] is the cheapest depot -> S path ending at j,
+//     and route[S] = min_j best[S][j] + d(j, 0) prices every subset as one route.
+//  2. Set partition: f_k[S] = min(f_k-1[S], min over T in S holding S's lowest node of
+//     route[T] + f_k-1[S \ T]).
+// When the depot never shortcuts a leg (d(a,0) + d(0,b) >= d(a,b) for all a, b),
+// joining two routes never costs more, so one route is optimal and step 2 is
+// skipped. Both steps are split across threads: Held-Karp one subset size at a
+// time, the partition rounds over independent subsets.
+template <typename Matrix>
+std::vector<std::vector<int>> bruteForceVRP(const Matrix& matrix, int numVehicles, const ExactParams& params) {
+    int n = matrix.customers();
+    if (n > EXACT_MAX_CUSTOMERS) {
+        throw std::runtime_error("Exact solver supports at most " + std::to_string(EXACT_MAX_CUSTOMERS) +
+                                 " delivery points, got " + std::to_string(n));
+    }
+    if (numVehicles < 1) {
+        throw std::runtime_error("Exact solver needs at least one vehicle, got " + std::to_string(numVehicles));
+    }
+    if (n == 0) {
+        return {};
+    }
+
+    const int INF = std::numeric_limits<int>::max() / 2;
+    const int full = (1 << n) - 1;
+
+    // Customers are bit i - 1 of a subset
+    std::vector<std::vector<int>> layers(n + 1);
+    for (int s = 1; s <= full; s++) {
+        layers[__builtin_popcount(s)].push_back(s);
+    }
+
+    // Held-Karp over paths from the depot
+    std::vector<int> best(size_t(full + 1) * n, INF);
+    for (int j = 0; j < n; j++) {
+        best[size_t(1 << j) * n + j] = matrix(0, j + 1);
+    }
+    for (int size = 2; size <= n; size++) {
+        const auto& layer = layers[size];
+        parallelFor(0, layer.size(), params.threads, [&](int index) {
+            int s = layer[index];
+            for (int j = 0; j < n; j++) {
+                if (!(s >> j & 1)) continue;
+                int without = s & ~(1 << j);
+                const int* from = &best[size_t(without) * n];
+                int cheapest = INF;
+                for (int i = 0; i < n; i++) {
+                    if ((without >> i & 1) && from[i] + matrix(i + 1, j + 1) < cheapest) {
+                        cheapest = from[i] + matrix(i + 1, j + 1);
+                    }
+                }
+                best[size_t(s) * n + j] = cheapest;
+            }
+        });
+    }
+
+    std::vector<int> route(full + 1, 0);
+    parallelFor(1, full + 1, params.threads, [&](int s) {
+        int cheapest = INF;
+        for (int j = 0; j < n; j++) {
+            if ((s >> j & 1) && best[size_t(s) * n + j] + matrix(j + 1, 0) < cheapest) {
+                cheapest = best[size_t(s) * n + j] + matrix(j + 1, 0);
+            }
+        }
+        route[s] = cheapest;
+    });
+
+    // Set partition into at most numVehicles routes; choice[k][S] is the
+    // first route of the best split of S into at most k + 1 routes
+    bool depotShortcuts = false;
+    for (int a = 1; a <= n && !depotShortcuts; a++) {
+        for (int b = 1; b <= n; b++) {
+            if (a != b && matrix(a, 0) + matrix(0, b) < matrix(a, b)) {
+                depotShortcuts = true;
+                break;
+            }
+        }
+    }
+    int rounds = depotShortcuts ? std::min(numVehicles, n) : 1;
+
+    std::vector<std::vector<int>> choice(rounds);
+    std::vector<int> current = route;
+    choice[0].resize(full + 1);
+    for (int s = 1; s <= full; s++) {
+        choice[0][s] = s;
+    }
+    for (int k = 1; k < rounds; k++) {
+        std::vector<int> next(full + 1, 0);
+        choice[k].resize(full + 1);
+        auto relax = [&](int s) {
+            int low = s & -s;
+            int rest = s & ~low;
+            // Keeping the previous round's split is always allowed
+            int cheapest = current[s];
+            int chosen = choice[k - 1][s];
+            // Every proper subset T of s that contains s's lowest node
+            for (int t = (rest - 1) & rest; ; t = (t - 1) & rest) {
+                int part = t | low;
+                if (route[part] + current[s & ~part] < cheapest) {
+                    cheapest = route[part] + current[s & ~part];
+                    chosen = part;
+                }
+                if (t == 0) break;
+            }
+            next[s] = cheapest;
+            choice[k][s] = chosen;
+        };
+        if (k + 1 == rounds) {
+            // Only the full set is needed from the last round
+            relax(full);
+        } else {
+            parallelFor(1, full + 1, params.threads, relax);
+        }
+        current.swap(next);
+    }
+
+    // Rebuild the visiting order of one route from the Held-Karp table
+    auto buildRoute = [&](int s) {
+        std::vector<int> order;
+        int last = -1;
+        int cheapest = INF;
+        for (int j = 0; j < n; j++) {
+            if ((s >> j & 1) && best[size_t(s) * n + j] + matrix(j + 1, 0) < cheapest) {
+                cheapest = best[size_t(s) * n + j] + matrix(j + 1, 0);
+                last = j;
+            }
+        }
+        while (s != 0) {
+            order.push_back(last + 1);
+            int without = s & ~(1 << last);
+            int target = best[size_t(s) * n + last];
+            int previous = -1;
+            for (int i = 0; i < n && without != 0; i++) {
+                if ((without >> i & 1) && best[size_t(without) * n + i] + matrix(i + 1, last + 1) == target) {
+                    previous = i;
+                    break;
+                }
+            }
+            s = without;
+            last = previous;
+        }
+        order.push_back(0);
+        std::reverse(order.begin(), order.end());
+        order.push_back(0);
+        return order;
+    };
+
+    std::vector<std::vector<int>> bestSolution;
+    int remaining = full;
+    for (int k = rounds - 1; remaining != 0; k--) {
+        int part = choice[std::max(k, 0)][remaining];
+        bestSolution.push_back(buildRoute(part));
+        remaining &= ~part;
+    }
+
+    return bestSolution;
+}
+
+template <typename Matrix>
+std::vector<std::vector<int>> bruteForceVRP(const Matrix& matrix, int numVehicles) {
+    return bruteForceVRP(matrix, numVehicles, ExactParams());
+}
+
+#endif
@@ -1,5 +1,14 @@
-g++ brute_force.cpp -o ../brute_force
-g++ nearest_neighbor.cpp -o ../nearest_neighbor
-g++ clarke_wright.cpp -o ../clarke_wright
-g++ genetic_algorithm.cpp -o ../genetic_algorithm
-g++ simulated_annealing.cpp -o ../simulated_annealing
\ No newline at end of file
+g++ -O3 -std=c++17 brute_force.cpp -o ../brute_force -pthread
+g++ -O3 -std=c++17 nearest_neighbor.cpp -o ../nearest_neighbor -pthread
+g++ -O3 -std=c++17 clarke_wright.cpp -o ../clarke_wright -pthread
+g++ -O3 -std=c++17 genetic_algorithm.cpp -o ../genetic_algorithm -pthread
+g++ -O3 -std=c++17 simulated_annealing.cpp -o ../simulated_annealing -pthread
+g++ -O3 -std=c++17 vrp_server.cpp -o ../vrp_server -pthread
+g++ -O3 -std=c++17 vrp_bench.cpp -o ../vrp_bench -pthread
+g++ -O3 -std=c++17 vrp_matrix.cpp -o ../vrp_matrix -pthread
+g++ -O3 -std=c++17 reoptimize.cpp -o ../reoptimize -pthread
+g++ -O3 -std=c++17 vrp_batch.cpp -o ../vrp_batch -pthread
+g++ -O3 -std=c++17 decompose.cpp -o ../decompose -pthread
+g++ -O3 -std=c++17 portfolio.cpp -o ../portfolio -pthread
+g++ -O3 -std=c++17 -shared -fPIC $(python3-config --includes) vrp_native.cpp -o ../vrp_native$(python3-config --extension-suffix) -pthread
+g++ -O3 -std=c++17 self_check.cpp -o ../self_check -pthread && ../self_check
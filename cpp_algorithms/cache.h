@@ -0,0 +1,227 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "common.h"
+#include "constraints.h"
+#include <atomic>
+#include <cerrno>
+#include <dirent.h>
+#include <sys/file.h>
+#include <thread>
+
+// 64-bit content hash for cache keys
+// Words are folded in with a multiply/xor-shift mix, 8 bytes at a time, so
+// hashing a large matrix costs about as much as reading it once.
+class ContentHash {
+public:
+    void add(const void* bytes, size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(bytes);
+        for (; size >= 8; p += 8, size -= 8) {
+            uint64_t word;
+            std::memcpy(&word, p, 8);
+            mix(word);
+        }
+        uint64_t tail = 0;
+        std::memcpy(&tail, p, size);
+        mix(tail ^ (uint64_t(size) << 56));
+    }
+
+    void add(int64_t value) { mix(uint64_t(value)); }
+
+    void add(const std::string& text) {
+        add(int64_t(text.size()));
+        add(text.data(), text.size());
+    }
+
+    void add(const std::vector<int>& values) {
+        add(int64_t(values.size()));
+        add(values.data(), values.size() * sizeof(int));
+    }
+
+    // Every row of the matrix, without the row padding; compact rows are
+    // widened first so a matrix hashes the same whatever its cell type
+    template <typename Distance>
+    void add(const BasicDistanceMatrix<Distance>& matrix) {
+        add(int64_t(matrix.size()));
+        std::vector<int> widened(BasicDistanceMatrix<Distance>::COMPACT ? matrix.size() : 0);
+        for (int i = 0; i < matrix.size(); i++) {
+            if constexpr (BasicDistanceMatrix<Distance>::COMPACT) {
+                for (int j = 0; j < matrix.size(); j++) {
+                    widened[j] = matrix(i, j);
+                }
+                add(widened.data(), widened.size() * sizeof(int));
+            } else {
+                add(matrix.row(i), matrix.size() * sizeof(int));
+            }
+        }
+    }
+
+    std::string hex() const {
+        uint64_t value = state ^ (state >> 31);
+        char text[17];
+        std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+        return text;
+    }
+
+private:
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+
+    void mix(uint64_t word) {
+        state = (state ^ word) * 0xFF51AFD7ED558CCDull;
+        state ^= state >> 32;
+    }
+};
+
+// Content-addressed cache in a directory, shared by concurrent processes
+// Each entry is one file named by its key. Entries are published by writing
+// a private temporary file and renaming it into place, so readers see either
+// the whole old entry or the whole new one and never a partial write. A hit
+// bumps the file's mtime, which makes mtime the LRU order: after every store
+// the oldest entries are deleted until the directory fits in maxBytes. Only
+// one process evicts at a time (flock on ".lock"); a reader whose entry is
+// evicted mid-read still has the open file.
+class DiskCache {
+public:
+    DiskCache(const std::string& directory, size_t maxBytes) : directory(directory), maxBytes(maxBytes) {
+        if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw std::runtime_error("Error creating cache directory: " + directory);
+        }
+    }
+
+    // Entry contents, or false on a miss; a hit counts as a use
+    bool load(const std::string& key, std::string& value) const {
+        if (!peek(key, value)) {
+            return false;
+        }
+        utimensat(AT_FDCWD, path(key).c_str(), nullptr, 0);
+        return true;
+    }
+
+    // At most limit leading bytes of an entry, without counting as a use
+    bool peek(const std::string& key, std::string& value, size_t limit = std::string::npos) const {
+        std::ifstream file(path(key), std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            return false;
+        }
+        size_t size = std::min(size_t(file.tellg()), limit);
+        value.assign(size, '\0');
+        file.seekg(0);
+        return bool(file.read(&value[0], size));
+    }
+
+    void store(const std::string& key, const std::string& value) const {
+        static std::atomic<unsigned> counter{0};
+        std::string temporary = directory + "/.tmp-" + std::to_string(getpid()) + "-" +
+                                std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "-" +
+                                std::to_string(counter++);
+        {
+            std::ofstream file(temporary, std::ios::binary);
+            if (!file.write(value.data(), value.size())) {
+                unlink(temporary.c_str());
+                return; // A full disk only costs the cache entry
+            }
+        }
+        if (rename(temporary.c_str(), path(key).c_str()) != 0) {
+            unlink(temporary.c_str());
+            return;
+        }
+        evict();
+    }
+
+    // Keys of the entries starting with prefix, most recently used first
+    std::vector<std::string> keys(const std::string& prefix) const {
+        std::vector<std::pair<timespec, std::string>> found;
+        for (const auto& entry : entries()) {
+            if (entry.name.compare(0, prefix.size(), prefix) == 0) {
+                found.push_back({entry.used, entry.name});
+            }
+        }
+        std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) { return newer(a.first, b.first); });
+        std::vector<std::string> names;
+        for (auto& item : found) {
+            names.push_back(std::move(item.second));
+        }
+        return names;
+    }
+
+private:
+    struct Entry {
+        std::string name;
+        size_t bytes;
+        timespec used;
+    };
+
+    std::string directory;
+    size_t maxBytes;
+
+    std::string path(const std::string& key) const { return directory + "/" + key; }
+
+    static bool newer(const timespec& a, const timespec& b) {
+        return a.tv_sec != b.tv_sec ? a.tv_sec > b.tv_sec : a.tv_nsec > b.tv_nsec;
+    }
+
+    // Published entries; temporaries and the lock file start with '.'
+    std::vector<Entry> entries() const {
+        std::vector<Entry> list;
+        DIR* handle = opendir(directory.c_str());
+        if (handle == nullptr) {
+            return list;
+        }
+        while (dirent* item = readdir(handle)) {
+            struct stat info;
+            if (item->d_name[0] == '.' || stat(path(item->d_name).c_str(), &info) != 0) {
+                continue;
+            }
+            list.push_back({item->d_name, size_t(info.st_size), info.st_mtim});
+        }
+        closedir(handle);
+        return list;
+    }
+
+    void evict() const {
+        int lock = open(path(".lock").c_str(), O_CREAT | O_RDWR, 0644);
+        if (lock < 0) {
+            return;
+        }
+        // When another process is already evicting, it will trim this entry too
+        if (flock(lock, LOCK_EX | LOCK_NB) == 0) {
+            std::vector<Entry> list = entries();
+            size_t total = 0;
+            for (const auto& entry : list) {
+                total += entry.bytes;
+            }
+            std::sort(list.begin(), list.end(), [](const Entry& a, const Entry& b) { return newer(b.used, a.used); });
+            for (size_t k = 0; k < list.size() && total > maxBytes; k++) {
+                unlink(path(list[k].name).c_str());
+                total -= list[k].bytes;
+            }
+            flock(lock, LOCK_UN);
+        }
+        close(lock);
+    }
+};
+
+// Cache key of a solve: everything that decides which routes come back
+// Shared by vrp_server and the vrp_native Python module, so either can
+// answer a request the other stored
+template <typename Matrix>
+std::string solutionKey(const std::string& algorithm, const Matrix& matrix, int numVehicles, unsigned seed,
+                        bool improve, double timeLimitMs, const Constraints* limits) {
+    ContentHash hash;
+    hash.add(algorithm);
+    hash.add(matrix);
+    hash.add(int64_t(numVehicles));
+    hash.add(int64_t(seed));
+    hash.add(int64_t(improve));
+    hash.add(int64_t(timeLimitMs * 1000.0));
+    if (limits != nullptr) {
+        hash.add(limits->demands);
+        hash.add(int64_t(limits->capacity));
+        hash.add(limits->ready);
+        hash.add(limits->due);
+        hash.add(limits->service);
+    }
+    return "solution-" + hash.hex() + ".json";
+}
+
+#endif
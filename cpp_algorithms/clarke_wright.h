@@ -0,0 +1,192 @@
+#ifndef CLARKE_WRIGHT_H
+#define CLARKE_WRIGHT_H
+
+#include "common.h"
+#include "neighbors.h"
+#include "telemetry.h"
+#include "constraints.h"
+
+// Tuning knobs for clarkeWrightVRP
+struct ClarkeWrightParams {
+    int neighbors = 40;  // Savings are only generated between each node and its k nearest
+    int threads = 1;     // Threads used to build the candidate lists
+    Telemetry* telemetry = nullptr;  // Savings and merge counters
+    const Constraints* constraints = nullptr;  // Capacity/time windows every merge must respect
+};
+
+// Clarke-Wright savings algorithm for VRP
+// Routes are doubly linked chains of customers; union-find maps every node
+// to its route's representative, which holds the route's head, tail and
+// cost. Savings are only generated for candidate pairs (i, j) with j among
+// i's k nearest neighbours and are consumed lazily from a heap, so memory
+// stays O(N k) and each merge is near-constant time.
+// With constraints, each representative also keeps its route's segment
+// summary, so a merge is checked by joining two summaries in O(1); merges
+// that would break a constraint are skipped, and the routes that cannot be
+// merged further are returned even if there are more than numVehicles.
+template <typename Matrix>
+std::vector<std::vector<int>> clarkeWrightVRP(const Matrix& matrix, int numVehicles, const ClarkeWrightParams& params) {
+    int n = matrix.customers();
+
+    // Savings of appending the route starting at j to the route ending at i:
+    // dist(i,0) + dist(0,j) - dist(i,j). Both directions of every candidate
+    // pair are listed because either node may end up as the tail.
+    struct Saving {
+        int value, i, j;
+        bool operator<(const Saving& other) const { return value < other.value; }
+    };
+    NeighborLists candidates(matrix, params.neighbors, params.threads);
+    std::vector<Saving> savings;
+    savings.reserve(size_t(n) * candidates.k() * 2);
+    for (int i = 1; i <= n; i++) {
+        const int* near = candidates.of(i);
+        for (int c = 0; c < candidates.k(); c++) {
+            int j = near[c];
+            savings.push_back({matrix(i, 0) + matrix(0, j) - matrix(i, j), i, j});
+            savings.push_back({matrix(j, 0) + matrix(0, i) - matrix(j, i), j, i});
+        }
+    }
+    std::make_heap(savings.begin(), savings.end());
+
+    const Constraints* constraints =
+        params.constraints != nullptr && params.constraints->active() ? params.constraints : nullptr;
+    std::vector<RouteSegment> segment(constraints != nullptr ? n + 1 : 0);
+
+    // Initialize routes - one vehicle per node initially
+    std::vector<int> next(n + 1, 0), prev(n + 1, 0);  // 0 marks a route end
+    std::vector<int> parent(n + 1), head(n + 1), tail(n + 1), cost(n + 1);
+    for (int i = 1; i <= n; i++) {
+        parent[i] = i;
+        head[i] = tail[i] = i;
+        cost[i] = matrix(0, i) + matrix(i, 0);
+        if (constraints != nullptr) {
+            segment[i] = constraints->node(i);
+        }
+    }
+    auto find = [&](int node) {
+        while (parent[node] != node) {
+            parent[node] = parent[parent[node]];
+            node = parent[node];
+        }
+        return node;
+    };
+
+    // Link route b after route a; the result keeps a's representative
+    auto merge = [&](int a, int b, int mergedCost) {
+        next[tail[a]] = head[b];
+        prev[head[b]] = tail[a];
+        parent[b] = a;
+        tail[a] = tail[b];
+        cost[a] = mergedCost;
+        if (constraints != nullptr) {
+            segment[a] = constraints->join(segment[a], segment[b], matrix);
+        }
+    };
+
+    // Whether depot -> a -> b -> depot keeps every constraint
+    RouteSegment depot = constraints != nullptr ? constraints->node(0) : RouteSegment();
+    auto feasible = [&](int a, int b) {
+        if (constraints == nullptr) {
+            return true;
+        }
+        RouteSegment merged = constraints->join(segment[a], segment[b], matrix);
+        merged = constraints->join(constraints->join(depot, merged, matrix), depot, matrix);
+        return constraints->violation(merged) == 0;
+    };
+
+    // Merge routes based on savings
+    long long savingsGenerated = savings.size();
+    long long mergesAttempted = 0;
+    int numRoutes = n;
+    while (!savings.empty() && numRoutes > numVehicles) {
+        std::pop_heap(savings.begin(), savings.end());
+        Saving saving = savings.back();
+        savings.pop_back();
+        mergesAttempted++;
+
+        int routeI = find(saving.i);
+        int routeJ = find(saving.j);
+
+        // Merge only if i is end of its route and j is start of another
+        if (routeI != routeJ && tail[routeI] == saving.i && head[routeJ] == saving.j &&
+            feasible(routeI, routeJ)) {
+            merge(routeI, routeJ, cost[routeI] + cost[routeJ] - saving.value);
+            numRoutes--;
+        }
+    }
+
+    long long mergesAccepted = n - numRoutes;
+
+    std::vector<int> roots;
+    for (int i = 1; i <= n; i++) {
+        if (parent[i] == i) {
+            roots.push_back(i);
+        }
+    }
+
+    // If we have too many routes, merge until we have numVehicles:
+    // append the shortest route to the route that grows the least.
+    // Under constraints the shortest route that has a feasible partner is
+    // used, and merging stops when no pair of routes can be joined.
+    std::vector<char> stuck(n + 1, 0);
+    while (int(roots.size()) > numVehicles) {
+        int shortest = -1;
+        for (size_t r = 0; r < roots.size(); r++) {
+            if (!stuck[roots[r]] && (shortest < 0 || cost[roots[r]] < cost[roots[shortest]])) {
+                shortest = r;
+            }
+        }
+        if (shortest < 0) {
+            break;
+        }
+        int s = roots[shortest];
+
+        int bestMerge = -1;
+        int minMergedLength = std::numeric_limits<int>::max();
+        for (size_t r = 0; r < roots.size(); r++) {
+            if (int(r) == shortest) continue;
+            int a = roots[r];
+            int mergedLength = cost[a] + cost[s] - matrix(tail[a], 0) - matrix(0, head[s]) + matrix(tail[a], head[s]);
+            if (mergedLength < minMergedLength && feasible(a, s)) {
+                minMergedLength = mergedLength;
+                bestMerge = r;
+            }
+        }
+        if (bestMerge < 0) {
+            stuck[s] = 1;
+            continue;
+        }
+
+        merge(roots[bestMerge], s, minMergedLength);
+        roots.erase(roots.begin() + shortest);
+    }
+
+    if (params.telemetry != nullptr) {
+        params.telemetry->setCounter("candidate_neighbors", candidates.k());
+        params.telemetry->setCounter("savings_generated", savingsGenerated);
+        params.telemetry->setCounter("merges_attempted", mergesAttempted);
+        params.telemetry->setCounter("merges_accepted", mergesAccepted);
+        params.telemetry->setCounter("forced_merges", numRoutes - int(roots.size()));
+    }
+
+    // Walk each chain from its head; routes keep the order of the route
+    // each merge was appended to, as the original erase-based version did
+    std::vector<std::vector<int>> routes;
+    for (int root : roots) {
+        std::vector<int> route = {0};
+        for (int node = head[root]; node != 0; node = next[node]) {
+            route.push_back(node);
+        }
+        route.push_back(0);
+        routes.push_back(std::move(route));
+    }
+
+    return routes;
+}
+
+template <typename Matrix>
+std::vector<std::vector<int>> clarkeWrightVRP(const Matrix& matrix, int numVehicles) {
+    return clarkeWrightVRP(matrix, numVehicles, ClarkeWrightParams());
+}
+
+#endif
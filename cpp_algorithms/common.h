@@ -10,38 +10,470 @@
 #include <cmath>
 #include <random>
 #include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <charconv>
+#include <cctype>
+#include <cstdint>
+#include <type_traits>
 
-// Read distance matrix from input.txt
-std::vector<std::vector<int>> readDistanceMatrix(const std::string& filename = "input.txt") {
-    std::ifstream file(filename);
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <malloc.h>
+#endif
+
+// Buffer of at least `bytes` bytes starting on an `alignment` boundary (a
+// power of two), freed when the last owner goes; empty when allocation fails.
+// MSVC and MinGW have no std::aligned_alloc, so Windows uses _aligned_malloc.
+inline std::shared_ptr<void> allocateAligned(size_t alignment, size_t bytes) {
+    bytes = std::max((bytes + alignment - 1) / alignment * alignment, alignment);
+#ifndef _WIN32
+    void* buffer = std::aligned_alloc(alignment, bytes);
+    return buffer == nullptr ? nullptr : std::shared_ptr<void>(buffer, std::free);
+#else
+    void* buffer = _aligned_malloc(bytes, alignment);
+    return buffer == nullptr ? nullptr : std::shared_ptr<void>(buffer, _aligned_free);
+#endif
+}
+
+// Dense (N+1)x(N+1) distance matrix with the depot at index 0.
+// Rows live in one contiguous buffer and are padded to a 64-byte multiple so
+// every row starts on a cache line; d(i, j) is the distance from i to j with
+// no depot special-casing. Copies share the underlying buffer.
+// Distance is the stored cell type: int, or uint16_t to halve the memory
+// traffic of large matrices. A uint16_t cell holds the distance divided by
+// scale() (1 when every distance fits), and d(i, j) is always returned as an
+// int in the original units, so solvers and reported costs are unchanged.
+template <typename Distance>
+class BasicDistanceMatrix {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr bool COMPACT = !std::is_same<Distance, int>::value;
+    static constexpr bool SPARSE = false;
+
+    BasicDistanceMatrix() = default;
+
+    // Zero-filled matrix for numCustomers delivery points plus the depot
+    explicit BasicDistanceMatrix(int numCustomers)
+        : n(numCustomers), rowStride(paddedStride(numCustomers + 1)) {
+        size_t bytes = rowStride * (n + 1) * sizeof(Distance);
+        storage = allocateAligned(ALIGNMENT, bytes);
+        if (storage == nullptr) {
+            throw std::runtime_error("Error allocating distance matrix for " + std::to_string(numCustomers) + " nodes");
+        }
+        std::memset(storage.get(), 0, bytes);
+        data = static_cast<Distance*>(storage.get());
+    }
+
+    // Number of delivery points (excluding the depot)
+    int customers() const { return n; }
+
+    // Number of nodes including the depot
+    int size() const { return n + 1; }
+
+    // Distance in cells between the starts of consecutive rows
+    size_t stride() const { return rowStride; }
+
+    int operator()(int from, int to) const {
+        if constexpr (COMPACT) {
+            return int(data[from * rowStride + to]) * unit;
+        } else {
+            return data[from * rowStride + to];
+        }
+    }
+
+    void set(int from, int to, int distance) {
+        if constexpr (COMPACT) {
+            int cell = std::max((distance + unit / 2) / unit, 0);
+            data[from * rowStride + to] = Distance(std::min(cell, int(std::numeric_limits<Distance>::max())));
+        } else {
+            data[from * rowStride + to] = distance;
+        }
+    }
+
+    // Raw cells; multiply by scale() for distances
+    const Distance* row(int from) const { return data + from * rowStride; }
+
+    // Writable row for bulk fills
+    Distance* row(int from) { return data + from * rowStride; }
+
+    // Distance units per stored unit (always 1 for int cells)
+    int scale() const { return unit; }
+
+    // Only meaningful before cells are set
+    void setScale(int value) { unit = std::max(1, value); }
+
+    // True when d(i, j) == d(j, i) is known to hold for every pair
+    bool symmetric() const { return isSymmetric; }
+
+    void setSymmetric(bool value) { isSymmetric = value; }
+
+    // Full O(N^2) scan for d(i, j) == d(j, i); use setSymmetric to record it
+    bool checkSymmetric() const {
+        for (int i = 0; i <= n; i++) {
+            for (int j = i + 1; j <= n; j++) {
+                if ((*this)(i, j) != (*this)(j, i)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // View over an existing row-major buffer (e.g. a memory-mapped file)
+    // without copying; owner keeps the buffer alive
+    static BasicDistanceMatrix wrap(int numCustomers, size_t stride, std::shared_ptr<void> owner, Distance* buffer,
+                                    int scale = 1) {
+        BasicDistanceMatrix matrix;
+        matrix.n = numCustomers;
+        matrix.rowStride = stride;
+        matrix.storage = std::move(owner);
+        matrix.data = buffer;
+        matrix.unit = std::max(1, scale);
+        return matrix;
+    }
+
+    // Matrix restricted to the depot plus the given delivery points,
+    // which are renumbered 1..nodes.size() in the order given
+    BasicDistanceMatrix subMatrix(const std::vector<int>& nodes) const {
+        int k = nodes.size();
+        BasicDistanceMatrix result(k);
+        result.setScale(unit);
+        for (int i = 0; i <= k; i++) {
+            int from = (i == 0) ? 0 : nodes[i - 1];
+            for (int j = 0; j <= k; j++) {
+                int to = (j == 0) ? 0 : nodes[j - 1];
+                result.set(i, j, (*this)(from, to));
+            }
+        }
+        result.setSymmetric(isSymmetric);
+        return result;
+    }
+
+    // Compact rows keep at least one spare cell, so a 32-bit gather of a
+    // row's last 16-bit entry never reads past the buffer
+    static size_t paddedStride(int columns) {
+        const size_t perLine = ALIGNMENT / sizeof(Distance);
+        return (columns + (COMPACT ? 1 : 0) + perLine - 1) / perLine * perLine;
+    }
+
+private:
+    int n = 0;
+    size_t rowStride = 0;
+    std::shared_ptr<void> storage;
+    Distance* data = nullptr;
+    int unit = 1;
+    bool isSymmetric = false;
+};
+
+using DistanceMatrix = BasicDistanceMatrix<int>;
+using CompactDistanceMatrix = BasicDistanceMatrix<uint16_t>;
+
+// Binary matrix file: a 64-byte header followed by (N+1) rows of `stride`
+// little-endian values, depot first. The header size keeps rows of a
+// memory-mapped file on the same 64-byte boundaries as DistanceMatrix.
+// uint16 files store distance / scale; older files have scale 0, read as 1.
+const char MATRIX_FILE_MAGIC[4] = {'V', 'R', 'P', 'M'};
+const uint32_t MATRIX_FILE_VERSION = 1;
+const uint32_t MATRIX_DTYPE_INT32 = 1;
+const uint32_t MATRIX_DTYPE_UINT16 = 2;
+const uint32_t MATRIX_FLAG_SYMMETRIC = 1;
+
+struct MatrixFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t customers;
+    uint32_t dtype;
+    uint32_t flags;
+    uint32_t stride;
+    uint32_t scale;
+    uint8_t reserved[36];
+};
+static_assert(sizeof(MatrixFileHeader) == 64, "matrix file header must stay 64 bytes");
+
+template <typename Distance>
+constexpr uint32_t matrixFileType() {
+    return BasicDistanceMatrix<Distance>::COMPACT ? MATRIX_DTYPE_UINT16 : MATRIX_DTYPE_INT32;
+}
+
+// Header of a binary matrix file; false when the file is not one
+inline bool readMatrixFileHeader(const std::string& filename, MatrixFileHeader& header) {
+    std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
-        std::cerr << "Error opening input file: " << filename << std::endl;
-        exit(1);
+        throw std::runtime_error("Error opening input file: " + filename);
     }
+    return file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+           std::memcmp(header.magic, MATRIX_FILE_MAGIC, 4) == 0;
+}
+
+// Map a binary matrix file with cells of type Distance into memory; the
+// returned matrix reads straight from the mapping
+template <typename Distance>
+BasicDistanceMatrix<Distance> mapBinaryMatrix(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening input file: " + filename);
+    }
+    size_t fileSize = file.tellg();
+    file.seekg(0);
+
+    MatrixFileHeader header;
+    if (fileSize < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, MATRIX_FILE_MAGIC, 4) != 0) {
+        throw std::runtime_error("Error: " + filename + " is not a binary matrix file");
+    }
+    if (header.version != MATRIX_FILE_VERSION || header.dtype != matrixFileType<Distance>()) {
+        throw std::runtime_error("Error: unsupported matrix file version " + std::to_string(header.version) +
+                                 " / dtype " + std::to_string(header.dtype) + " in " + filename);
+    }
+    size_t dataBytes = size_t(header.customers + 1) * header.stride * sizeof(Distance);
+    // Compact rows need their spare cell (see paddedStride)
+    size_t minStride = header.customers + 1 + (BasicDistanceMatrix<Distance>::COMPACT ? 1 : 0);
+    if (header.stride < minStride || fileSize < sizeof(header) + dataBytes) {
+        throw std::runtime_error("Error: truncated matrix file: " + filename);
+    }
+
+#ifndef _WIN32
+    file.close();
+    int fd = open(filename.c_str(), O_RDONLY);
+    void* mapping = (fd < 0) ? MAP_FAILED
+                             : mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Error mapping input file: " + filename);
+    }
+    std::shared_ptr<void> owner(mapping, [fileSize](void* p) { munmap(p, fileSize); });
+    Distance* buffer = reinterpret_cast<Distance*>(static_cast<char*>(mapping) + sizeof(header));
+#else
+    std::shared_ptr<void> owner = allocateAligned(BasicDistanceMatrix<Distance>::ALIGNMENT, dataBytes);
+    if (owner == nullptr || !file.read(static_cast<char*>(owner.get()), dataBytes)) {
+        throw std::runtime_error("Error reading input file: " + filename);
+    }
+    Distance* buffer = static_cast<Distance*>(owner.get());
+#endif
+
+    auto matrix = BasicDistanceMatrix<Distance>::wrap(header.customers, header.stride, std::move(owner), buffer,
+                                                      header.scale);
+    matrix.setSymmetric(header.flags & MATRIX_FLAG_SYMMETRIC);
+    return matrix;
+}
+
+// Copy of a matrix with another cell type, stored with the given scale
+template <typename To, typename From>
+BasicDistanceMatrix<To> convertDistanceMatrix(const BasicDistanceMatrix<From>& matrix, int scale = 1) {
+    BasicDistanceMatrix<To> result(matrix.customers());
+    result.setScale(scale);
+    for (int i = 0; i < matrix.size(); i++) {
+        for (int j = 0; j < matrix.size(); j++) {
+            result.set(i, j, matrix(i, j));
+        }
+    }
+    result.setSymmetric(matrix.symmetric());
+    return result;
+}
+
+// Smallest scale at which every distance fits a uint16 cell (1 when they
+// all fit exactly), or 0 when a distance is negative
+inline int compactScale(const DistanceMatrix& matrix) {
+    int lowest = 0, highest = 0;
+    for (int i = 0; i < matrix.size(); i++) {
+        const int* row = matrix.row(i);
+        for (int j = 0; j < matrix.size(); j++) {
+            lowest = std::min(lowest, row[j]);
+            highest = std::max(highest, row[j]);
+        }
+    }
+    const int LIMIT = std::numeric_limits<uint16_t>::max();
+    if (lowest < 0) {
+        return 0;
+    }
+    return highest <= LIMIT ? 1 : int((highest + LIMIT - 1LL) / LIMIT);
+}
+
+// Read a binary matrix file as int cells; uint16 files are widened
+inline DistanceMatrix readBinaryDistanceMatrix(const std::string& filename) {
+    MatrixFileHeader header;
+    if (readMatrixFileHeader(filename, header) && header.dtype == MATRIX_DTYPE_UINT16) {
+        return convertDistanceMatrix<int>(mapBinaryMatrix<uint16_t>(filename));
+    }
+    return mapBinaryMatrix<int>(filename);
+}
+
+// Write a matrix in the binary format read by mapBinaryMatrix
+template <typename Distance>
+void writeBinaryDistanceMatrix(const BasicDistanceMatrix<Distance>& matrix, const std::string& filename) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening output file: " + filename);
+    }
+
+    bool symmetric = matrix.symmetric() || matrix.checkSymmetric();
+
+    MatrixFileHeader header = {};
+    std::memcpy(header.magic, MATRIX_FILE_MAGIC, 4);
+    header.version = MATRIX_FILE_VERSION;
+    header.customers = matrix.customers();
+    header.dtype = matrixFileType<Distance>();
+    header.flags = symmetric ? MATRIX_FLAG_SYMMETRIC : 0;
+    header.stride = matrix.stride();
+    header.scale = matrix.scale();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int i = 0; i < matrix.size(); i++) {
+        file.write(reinterpret_cast<const char*>(matrix.row(i)), matrix.stride() * sizeof(Distance));
+    }
+}
+
+// Parse the legacy text format from an in-memory buffer
+// The text holds N rows of N+1 columns: column 0 of row i-1 is the distance
+// between the depot and node i, and column j is the distance from node i to
+// node j. The depot column is used for both the outbound and return legs.
+inline DistanceMatrix parseTextDistanceMatrix(const char* first, const char* last, const std::string& filename) {
+    auto nextInt = [&](int& value) {
+        while (first != last && std::isspace(static_cast<unsigned char>(*first))) {
+            first++;
+        }
+        auto result = std::from_chars(first, last, value);
+        if (result.ec != std::errc()) {
+            throw std::runtime_error("Error: malformed number in input file: " + filename);
+        }
+        first = result.ptr;
+    };
 
     int n;
-    file >> n;
+    nextInt(n);
 
-    std::vector<std::vector<int>> matrix;
-    matrix.resize(n);
+    DistanceMatrix matrix(n);
     
-    for (int i = 0; i < n; i++) {
-        matrix[i].resize(n + 1);
-        for (int j = 0; j < n + 1; j++) {
-            file >> matrix[i][j];
+    for (int i = 1; i <= n; i++) {
+        int depotDistance;
+        nextInt(depotDistance);
+        matrix.set(0, i, depotDistance);
+        matrix.set(i, 0, depotDistance);
+        for (int j = 1; j <= n; j++) {
+            int distance;
+            nextInt(distance);
+            matrix.set(i, j, distance);
         }
     }
+    matrix.setSymmetric(matrix.checkSymmetric());
     
-    file.close();
     return matrix;
 }
 
+// Write a matrix in the legacy text format; the depot column holds d(0, i),
+// so asymmetric depot legs are only kept by the binary format
+inline void writeTextDistanceMatrix(const DistanceMatrix& matrix, const std::string& filename) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening output file: " + filename);
+    }
+    int n = matrix.customers();
+    std::string line;
+    char number[16];
+    file << n << "\n";
+    for (int i = 1; i <= n; i++) {
+        line.clear();
+        for (int j = 0; j <= n; j++) {
+            auto result = std::to_chars(number, number + sizeof(number), j == 0 ? matrix(0, i) : matrix(i, j));
+            line.append(number, result.ptr);
+            line += j < n ? ' ' : '\n';
+        }
+        file.write(line.data(), line.size());
+    }
+}
+
+// Read distance matrix from input.txt
+// Binary matrix files are recognised by their magic and memory-mapped;
+// anything else is parsed as the legacy text format
+inline DistanceMatrix readDistanceMatrix(const std::string& filename = "input.txt") {
+    // Only the header is read before mapping, so binary files are never copied
+    MatrixFileHeader header;
+    if (readMatrixFileHeader(filename, header)) {
+        return readBinaryDistanceMatrix(filename);
+    }
+
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening input file: " + filename);
+    }
+    std::string contents(file.tellg(), '\0');
+    file.seekg(0);
+    file.read(&contents[0], contents.size());
+    file.close();
+    return parseTextDistanceMatrix(contents.data(), contents.data() + contents.size(), filename);
+}
+
+// A matrix held with the cell type picked when it was loaded
+// visit(body) calls body(matrix) with whichever of the two it holds, so the
+// code inside is instantiated once per cell type.
+struct LoadedMatrix {
+    DistanceMatrix wide;
+    CompactDistanceMatrix compact;
+    bool isCompact = false;
+
+    template <typename Body>
+    auto visit(Body body) const {
+        return isCompact ? body(compact) : body(wide);
+    }
+};
+
+// Store a matrix as type "int32", "uint16" (quantized with a scale when
+// distances exceed 65535) or "auto": uint16 when every distance fits
+// exactly, so results are identical and only the memory traffic halves
+inline LoadedMatrix chooseDistanceType(DistanceMatrix matrix, const std::string& type = "auto") {
+    if (type != "auto" && type != "int32" && type != "uint16") {
+        throw std::runtime_error("Unknown distance type: " + type);
+    }
+    LoadedMatrix loaded;
+    int scale = type == "int32" ? 0 : compactScale(matrix);
+    if (type == "uint16" && scale == 0) {
+        throw std::runtime_error("Error: negative distances do not fit uint16 storage");
+    }
+    if (scale == 1 || (type == "uint16" && scale > 1)) {
+        if (scale > 1) {
+            std::cerr << "Warning: distances quantized to multiples of " << scale << " for uint16 storage" << std::endl;
+        }
+        loaded.compact = convertDistanceMatrix<uint16_t>(matrix, scale);
+        loaded.isCompact = true;
+    } else {
+        loaded.wide = std::move(matrix);
+    }
+    return loaded;
+}
+
+// Read a matrix file (see readDistanceMatrix) into the cell type asked for
+// Binary files already carry a cell type (see vrp_matrix --distance-type):
+// "auto" maps them as they are rather than converting a zero-copy mapping.
+inline LoadedMatrix loadDistanceMatrix(const std::string& filename, const std::string& type = "auto") {
+    MatrixFileHeader header;
+    if (type != "int32" && readMatrixFileHeader(filename, header)) {
+        LoadedMatrix loaded;
+        if (header.dtype == MATRIX_DTYPE_UINT16) {
+            loaded.compact = mapBinaryMatrix<uint16_t>(filename);
+            loaded.isCompact = true;
+            return loaded;
+        }
+        if (type == "auto") {
+            loaded.wide = mapBinaryMatrix<int>(filename);
+            return loaded;
+        }
+    }
+    return chooseDistanceType(readDistanceMatrix(filename), type);
+}
+
 // Write routes to output.txt
-void writeRoutes(const std::vector<std::vector<int>>& routes, const std::string& filename = "output.txt") {
+inline void writeRoutes(const std::vector<std::vector<int>>& routes, const std::string& filename = "output.txt") {
     std::ofstream file(filename);
     if (!file.is_open()) {
-        std::cerr << "Error opening output file: " << filename << std::endl;
-        exit(1);
+        throw std::runtime_error("Error opening output file: " + filename);
     }
     
     for (const auto& route : routes) {
@@ -57,42 +489,139 @@ void writeRoutes(const std::vector<std::vector<int>>& routes, const std::string&
     file.close();
 }
 
-// Calculate total distance of a route
-int calculateRouteDistance(const std::vector<int>& route, const std::vector<std::vector<int>>& matrix) {
-    int totalDistance = 0;
-    int prev = 0; // Start from depot (0)
-    
-    for (size_t i = 0; i < route.size(); i++) {
-        int current = route[i];
-        // If current is depot (0), use special case
-        if (current == 0) {
-            // If prev is also depot, distance is 0
-            if (prev == 0) {
-                totalDistance += 0;
-            } else {
-                // Use the first column of matrix (distances back to depot)
-                totalDistance += matrix[prev-1][0];
+// Read routes written by writeRoutes, one route per line
+inline std::vector<std::vector<int>> readRoutes(const std::string& filename = "output.txt") {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening routes file: " + filename);
+    }
+    std::vector<std::vector<int>> routes;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::vector<int> route;
+        const char* first = line.data();
+        const char* last = first + line.size();
+        int node;
+        while (true) {
+            while (first != last && std::isspace(static_cast<unsigned char>(*first))) first++;
+            auto result = std::from_chars(first, last, node);
+            if (result.ec != std::errc()) break;
+            route.push_back(node);
+            first = result.ptr;
+        }
+        if (first != last) {
+            throw std::runtime_error("Error: malformed route in " + filename + ": " + line);
+        }
+        if (!route.empty()) {
+            routes.push_back(std::move(route));
+        }
+    }
+    return routes;
+}
+
+// Command line shared by the solver binaries:
+//   <binary> [numVehicles] [matrixFile] [--option value | --option=value | --flag ...]
+// A lone positional that is not a number is taken as matrixFile, so the
+// fleet size can be left out (reoptimize then keeps the previous fleet).
+// The flags below never take a value, so positionals may follow them;
+// --telemetry takes its optional file as --telemetry=FILE.
+const std::vector<std::string> COMMAND_LINE_FLAGS = {"local-search", "stream", "no-search", "telemetry"};
+
+struct CommandLine {
+    int numVehicles = 2;
+    bool hasNumVehicles = false;   // numVehicles was given rather than defaulted
+    std::string matrixFile = "input.txt";
+    std::vector<std::pair<std::string, std::string>> options;
+
+    bool has(const std::string& name) const {
+        for (const auto& option : options) {
+            if (option.first == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string get(const std::string& name, const std::string& fallback = "") const {
+        for (const auto& option : options) {
+            if (option.first == name) {
+                return option.second;
             }
-        } else if (prev == 0) {
-            // Distance from depot to current
-            totalDistance += matrix[current-1][0];
+        }
+        return fallback;
+    }
+
+    double getNumber(const std::string& name, double fallback) const {
+        std::string value = get(name);
+        return value.empty() ? fallback : std::atof(value.c_str());
+    }
+};
+
+inline CommandLine parseCommandLine(int argc, char** argv) {
+    CommandLine commandLine;
+    std::vector<std::string> positionals;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            std::string name = arg.substr(2), value;
+            size_t equals = name.find('=');
+            bool flag = std::find(COMMAND_LINE_FLAGS.begin(), COMMAND_LINE_FLAGS.end(), name) != COMMAND_LINE_FLAGS.end();
+            if (equals != std::string::npos) {
+                value = name.substr(equals + 1);
+                name.resize(equals);
+            } else if (!flag && i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                value = argv[++i];
+            }
+            commandLine.options.emplace_back(name, value);
         } else {
-            // Distance between two delivery points
-            totalDistance += matrix[prev-1][current];
+            positionals.push_back(arg);
         }
-        prev = current;
     }
-    
-    // If the route doesn't end at depot, add return to depot
-    if (route.back() != 0) {
-        totalDistance += matrix[route.back()-1][0];
+
+    auto isNumber = [](const std::string& text) {
+        return !text.empty() && text.find_first_not_of("+-0123456789") == std::string::npos;
+    };
+    if (positionals.size() == 1 && !isNumber(positionals[0])) {
+        commandLine.matrixFile = positionals[0];
+        return commandLine;
+    }
+    if (!positionals.empty()) {
+        const std::string& text = positionals[0];
+        int vehicles = 0;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), vehicles);
+        if (error != std::errc() || end != text.data() + text.size() || vehicles < 1) {
+            throw std::runtime_error("numVehicles must be a positive integer, got: " + text);
+        }
+        commandLine.numVehicles = vehicles;
+        commandLine.hasNumVehicles = true;
+    }
+    if (positionals.size() > 1) {
+        commandLine.matrixFile = positionals[1];
+    }
+    return commandLine;
+}
+
+// Calculate total distance of a route
+// Routes that do not start or end at the depot are closed through it;
+// d(0, 0) is zero, so explicit depot endpoints cost nothing extra.
+template <typename Matrix>
+int calculateRouteDistance(const std::vector<int>& route, const Matrix& matrix) {
+    if (route.empty()) {
+        return 0;
+    }
+
+    int totalDistance = matrix(0, route.front());
+    for (size_t i = 1; i < route.size(); i++) {
+        totalDistance += matrix(route[i - 1], route[i]);
     }
+    totalDistance += matrix(route.back(), 0);
     
     return totalDistance;
 }
 
 // Calculate total distance for multiple routes
-int calculateTotalDistance(const std::vector<std::vector<int>>& routes, const std::vector<std::vector<int>>& matrix) {
+template <typename Matrix>
+int calculateTotalDistance(const std::vector<std::vector<int>>& routes, const Matrix& matrix) {
     int totalDistance = 0;
     for (const auto& route : routes) {
         totalDistance += calculateRouteDistance(route, matrix);
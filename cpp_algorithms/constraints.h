@@ -0,0 +1,192 @@
+#ifndef CONSTRAINTS_H
+#define CONSTRAINTS_H
+
+#include "common.h"
+#include <sstream>
+
+// Open due time used when a node has no time window
+const int NO_DEADLINE = 1000000000;
+
+// Summary of a stretch of consecutive stops, in the segment algebra of
+// Vidal et al. (2013): enough to price the stretch's load and time window
+// behaviour when it is concatenated with any other stretch, so a route built
+// from a few known pieces is checked in O(1) instead of by walking it.
+struct RouteSegment {
+    int first = -1;     // First and last stop; -1 for the empty segment
+    int last = -1;
+    int load = 0;       // Total demand
+    int duration = 0;   // Travel, service and waiting time from first to last
+    int timeWarp = 0;   // Lateness that had to be absorbed to meet due times
+    int earliest = 0;   // Earliest start at first that achieves that duration
+    int latest = 0;     // Latest start at first that adds no time warp
+
+    bool empty() const { return first < 0; }
+};
+
+// Capacity and time window constraints (CVRP/VRPTW)
+// Every vector is indexed by matrix node, depot first. Travel times are the
+// matrix distances; service at node i may start anywhere in [ready[i], due[i]]
+// and takes service[i]. The depot's window is the planning horizon, so a
+// route must be back by due[0]. Empty vectors switch a constraint off.
+struct Constraints {
+    std::vector<int> demands;
+    int capacity = 0;             // 0 means unlimited
+    std::vector<int> ready;
+    std::vector<int> due;
+    std::vector<int> service;
+
+    bool hasCapacity() const { return capacity > 0 && !demands.empty(); }
+
+    bool hasTimeWindows() const { return !ready.empty(); }
+
+    bool active() const { return hasCapacity() || hasTimeWindows(); }
+
+    // Throw unless every vector covers exactly the matrix's nodes
+    template <typename Matrix>
+    void validate(const Matrix& matrix) const {
+        auto check = [&](const std::vector<int>& values, const char* what) {
+            if (!values.empty() && int(values.size()) != matrix.size()) {
+                throw std::runtime_error(std::string("Constraint ") + what + " has " + std::to_string(values.size()) +
+                                         " entries for " + std::to_string(matrix.size()) + " nodes");
+            }
+        };
+        check(demands, "demands");
+        check(ready, "ready times");
+        check(due, "due times");
+        check(service, "service times");
+        if (hasTimeWindows() && (due.empty() || service.empty())) {
+            throw std::runtime_error("Time windows need ready, due and service times for every node");
+        }
+    }
+
+    // Segment holding a single stop
+    RouteSegment node(int i) const {
+        RouteSegment segment;
+        segment.first = segment.last = i;
+        segment.load = demands.empty() ? 0 : demands[i];
+        if (hasTimeWindows()) {
+            segment.duration = service[i];
+            segment.earliest = ready[i];
+            segment.latest = due[i];
+        }
+        return segment;
+    }
+
+    // Segment a followed directly by segment b
+    template <typename Matrix>
+    RouteSegment join(const RouteSegment& a, const RouteSegment& b, const Matrix& matrix) const {
+        if (a.empty()) return b;
+        if (b.empty()) return a;
+        RouteSegment segment;
+        segment.first = a.first;
+        segment.last = b.last;
+        segment.load = a.load + b.load;
+        if (hasTimeWindows()) {
+            int travel = matrix(a.last, b.first);
+            int delta = a.duration - a.timeWarp + travel;
+            int wait = std::max(b.earliest - delta - a.latest, 0);
+            int warp = std::max(a.earliest + delta - b.latest, 0);
+            segment.duration = a.duration + b.duration + travel + wait;
+            segment.timeWarp = a.timeWarp + b.timeWarp + warp;
+            segment.earliest = std::max(b.earliest - delta, a.earliest) - wait;
+            segment.latest = std::min(b.latest - delta, a.latest) + warp;
+        }
+        return segment;
+    }
+
+    // Excess load plus time warp; 0 exactly when the segment is feasible
+    int violation(const RouteSegment& segment) const {
+        int excess = hasCapacity() ? std::max(segment.load - capacity, 0) : 0;
+        return excess + segment.timeWarp;
+    }
+
+    // Summary of a whole route, closed through the depot at both ends
+    template <typename Matrix>
+    RouteSegment route(const std::vector<int>& stops, const Matrix& matrix) const {
+        RouteSegment segment = node(0);
+        for (int stop : stops) {
+            if (stop != 0) segment = join(segment, node(stop), matrix);
+        }
+        return join(segment, node(0), matrix);
+    }
+
+    template <typename Matrix>
+    int violation(const std::vector<std::vector<int>>& routes, const Matrix& matrix) const {
+        int total = 0;
+        for (const auto& stops : routes) {
+            total += violation(route(stops, matrix));
+        }
+        return total;
+    }
+};
+
+// Read a constraints file
+//   CAPACITY <Q>                          (optional)
+//   <node> <demand> [<ready> <due> [<service>]]
+// one line per node, depot = 0; '#' starts a comment. Nodes that are not
+// listed have no demand and, if other nodes have windows, an open window.
+template <typename Matrix>
+Constraints readConstraints(const std::string& filename, const Matrix& matrix) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening constraints file: " + filename);
+    }
+
+    Constraints constraints;
+    constraints.demands.assign(matrix.size(), 0);
+    std::vector<int> ready(matrix.size(), 0), due(matrix.size(), NO_DEADLINE), service(matrix.size(), 0);
+    bool windows = false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first)) continue;
+        if (first == "CAPACITY") {
+            fields >> constraints.capacity;
+            continue;
+        }
+        int node = std::atoi(first.c_str());
+        if (node < 0 || node >= matrix.size()) {
+            throw std::runtime_error("Constraint for unknown node " + first + " in " + filename);
+        }
+        fields >> constraints.demands[node];
+        if (fields >> ready[node] >> due[node]) {
+            windows = true;
+            fields >> service[node];
+        }
+    }
+    if (windows) {
+        constraints.ready = std::move(ready);
+        constraints.due = std::move(due);
+        constraints.service = std::move(service);
+    }
+    return constraints;
+}
+
+// The --constraints FILE option: nullptr when absent
+template <typename Matrix>
+const Constraints* constraintsFromCommandLine(const CommandLine& commandLine, const Matrix& matrix,
+                                              Constraints& constraints) {
+    if (!commandLine.has("constraints")) {
+        return nullptr;
+    }
+    constraints = readConstraints(commandLine.get("constraints"), matrix);
+    return &constraints;
+}
+
+// Say so on stderr when the routes break the constraints, which happens when
+// the fleet is too small or a stop cannot be served on its own
+template <typename Matrix>
+void warnViolations(const Constraints* constraints, const std::vector<std::vector<int>>& routes, const Matrix& matrix) {
+    if (constraints == nullptr) {
+        return;
+    }
+    int violation = constraints->violation(routes, matrix);
+    if (violation > 0) {
+        std::cerr << "Warning: routes exceed capacity or time windows by " << violation << std::endl;
+    }
+}
+
+#endif
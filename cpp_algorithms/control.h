@@ -0,0 +1,243 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include "common.h"
+#include "json.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <mutex>
+
+// Set by SIGINT/SIGTERM once installStopSignals has run
+inline std::atomic<bool>& stopSignalFlag() {
+    static std::atomic<bool> flag(false);
+    return flag;
+}
+
+// Turn SIGINT/SIGTERM into a cooperative stop: solvers wind down at their
+// next check and the binary still writes the best solution found so far
+inline void installStopSignals() {
+    auto handler = [](int) { stopSignalFlag().store(true); };
+    std::signal(SIGINT, handler);
+    std::signal(SIGTERM, handler);
+}
+
+// Anytime control for one solve
+// Solvers receive a const SolveControl* through their params and poll
+// stopRequested() at natural checkpoints (a cooling step, a generation, a
+// batch of local search moves); every new best solution is handed to the
+// improvement callback as it is found. Both are thread-safe, so one control
+// can be shared by every chain or island of a solve, and cancel() may be
+// called from any thread.
+class SolveControl {
+public:
+    using Clock = std::chrono::steady_clock;
+    using ImprovementCallback = std::function<void(const std::vector<std::vector<int>>& routes, int distance)>;
+
+    SolveControl() : start(Clock::now()), deadline(Clock::time_point::max()) {}
+
+    // Stop once this many seconds have passed since the control was created
+    void setTimeLimit(double seconds) {
+        deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+
+    bool hasDeadline() const { return deadline != Clock::time_point::max(); }
+
+    void cancel() { cancelled.store(true); }
+
+    // Cancelled or interrupted, as opposed to stopped by the deadline: the
+    // routes are cut short arbitrarily and must not be cached
+    bool cancelRequested() const {
+        return cancelled.load(std::memory_order_relaxed) || stopSignalFlag().load(std::memory_order_relaxed);
+    }
+
+    bool stopRequested() const {
+        return cancelled.load(std::memory_order_relaxed) || stopSignalFlag().load(std::memory_order_relaxed) ||
+               (hasDeadline() && Clock::now() >= deadline);
+    }
+
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Seconds until the deadline (infinity without one, 0 once it has passed)
+    double remainingSeconds() const {
+        if (!hasDeadline()) {
+            return std::numeric_limits<double>::infinity();
+        }
+        return std::max(0.0, std::chrono::duration<double>(deadline - Clock::now()).count());
+    }
+
+    void onImprovement(ImprovementCallback callback) { improvement = std::move(callback); }
+
+    bool wantsImprovements() const { return bool(improvement); }
+
+    // Best distance reported so far; solvers skip building routes that would not beat it
+    int bestReported() const { return best.load(std::memory_order_relaxed); }
+
+    // Forward a solution only if it beats everything reported before
+    void reportImprovement(const std::vector<std::vector<int>>& routes, int distance) const {
+        if (!improvement || distance >= bestReported()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (distance < best.load()) {
+            best.store(distance);
+            improvement(routes, distance);
+        }
+    }
+
+private:
+    Clock::time_point start;
+    Clock::time_point deadline;
+    std::atomic<bool> cancelled{false};
+    ImprovementCallback improvement;
+    mutable std::atomic<int> best{std::numeric_limits<int>::max()};
+    mutable std::mutex mutex;
+};
+
+// Best solution shared by solvers racing on one instance (portfolio.h)
+// Solutions are immutable once published: offer() swaps a new one in with a
+// compare-and-swap on an atomic pointer, and read() copies the current one,
+// so neither takes a lock. A replaced solution goes on a retired stack and
+// is freed once no read() is in progress: offer() takes the whole stack and
+// frees it if the reader count is still zero after taking it (a read that
+// starts later can only see the solution that replaced them), otherwise it
+// puts the stack back for a later offer. distance() and version() are single
+// atomic loads, cheap enough to poll every cooling step or generation.
+class Incumbent {
+public:
+    struct Solution {
+        std::vector<std::vector<int>> routes;
+        int distance = 0;
+        std::string source;   // Solver that found it
+    };
+
+    Incumbent() = default;
+    Incumbent(const Incumbent&) = delete;
+    Incumbent& operator=(const Incumbent&) = delete;
+
+    ~Incumbent() {
+        delete current.load();
+        freeAll(retired.exchange(nullptr));
+    }
+
+    // Publish routes if they beat the current solution; true if they did
+    bool offer(const std::vector<std::vector<int>>& routes, int distance, const std::string& source) {
+        if (distance >= bestDistance.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        std::unique_ptr<Node> candidate(new Node{Solution{routes, distance, source}, nullptr});
+        Node* replaced = current.load();
+        while (replaced == nullptr || distance < replaced->solution.distance) {
+            if (current.compare_exchange_weak(replaced, candidate.get())) {
+                candidate.release();
+                int known = bestDistance.load();
+                while (distance < known && !bestDistance.compare_exchange_weak(known, distance)) {
+                }
+                versions.fetch_add(1);
+                if (replaced != nullptr) {
+                    retire(replaced, replaced);
+                }
+                reclaim();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Copy the current solution into solution; false before the first offer
+    bool read(Solution& solution) const {
+        readers.fetch_add(1);
+        const Node* node = current.load();
+        if (node != nullptr) {
+            solution = node->solution;
+        }
+        readers.fetch_sub(1);
+        return node != nullptr;
+    }
+
+    int distance() const { return bestDistance.load(std::memory_order_relaxed); }
+
+    // Bumped by every accepted offer
+    unsigned version() const { return versions.load(std::memory_order_acquire); }
+
+private:
+    struct Node {
+        Solution solution;
+        Node* next;   // Link in the retired stack
+    };
+
+    // Push the chain first..last onto the retired stack
+    void retire(Node* first, Node* last) {
+        last->next = retired.load();
+        while (!retired.compare_exchange_weak(last->next, first)) {
+        }
+    }
+
+    void reclaim() {
+        if (readers.load() != 0) {
+            return;
+        }
+        Node* stack = retired.exchange(nullptr);
+        if (stack == nullptr) {
+            return;
+        }
+        if (readers.load() == 0) {
+            freeAll(stack);
+            return;
+        }
+        Node* last = stack;
+        while (last->next != nullptr) {
+            last = last->next;
+        }
+        retire(stack, last);
+    }
+
+    static void freeAll(Node* node) {
+        while (node != nullptr) {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    std::atomic<Node*> current{nullptr};
+    std::atomic<Node*> retired{nullptr};
+    mutable std::atomic<int> readers{0};
+    std::atomic<int> bestDistance{std::numeric_limits<int>::max()};
+    std::atomic<unsigned> versions{0};
+
+    static_assert(std::atomic<Node*>::is_always_lock_free, "Incumbent needs a lock-free pointer swap");
+};
+
+// Null-safe helpers for solvers whose control pointer may be unset
+inline bool stopRequested(const SolveControl* control) {
+    return control != nullptr && control->stopRequested();
+}
+
+template <typename Matrix>
+void reportRoutes(const SolveControl* control, const Matrix& matrix, const std::vector<std::vector<int>>& routes) {
+    if (control != nullptr && control->wantsImprovements()) {
+        control->reportImprovement(routes, calculateTotalDistance(routes, matrix));
+    }
+}
+
+// The --time-limit SECONDS and --stream options; installs the signal handlers.
+// Streamed solutions are printed to stdout as one JSON line each.
+inline void configureControl(const CommandLine& commandLine, SolveControl& control) {
+    installStopSignals();
+    if (commandLine.has("time-limit")) {
+        control.setTimeLimit(commandLine.getNumber("time-limit", 0.0));
+    }
+    if (commandLine.has("stream")) {
+        const SolveControl* self = &control;
+        control.onImprovement([self](const std::vector<std::vector<int>>& routes, int distance) {
+            std::cout << "{\"elapsed_ms\":" << self->elapsedMs() << ",\"distance\":" << distance
+                      << ",\"routes\":" << routesToJson(routes) << "}" << std::endl;
+        });
+    }
+}
+
+#endif
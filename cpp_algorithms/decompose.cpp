@@ -0,0 +1,69 @@
+#include "decompose.h"
+#include "sparse_matrix.h"
+
+// Usage: decompose [numVehicles] [matrixFile] [--algorithm NAME]
+//          [--clusters medoids|sweep|routes] [--cluster-size S] [--rounds R]
+//          [--threads T] [--seed S] [--coordinates FILE]
+//          [--telemetry[=FILE]] [--time-limit SECONDS] [--stream]
+//          [--constraints FILE] [--distance-type auto|int32|uint16]
+//          [--sparse K [--metric haversine|equirectangular]]
+// Splits the stops into clusters of about S (default 200), solves each with
+// --algorithm (default clarke_wright) on T threads, stitches the routes and
+// runs R boundary re-optimization rounds (decompose.h). "sweep" clusters by
+// bearing from the depot and needs coordinates: the --sparse coordinates
+// file, or --coordinates FILE ("lat lon" lines, depot first) for a matrix.
+int main(int argc, char** argv) try {
+    CommandLine commandLine = parseCommandLine(argc, argv);
+    SolveControl control;
+    configureControl(commandLine, control);
+    Telemetry telemetry;
+    Telemetry* probe = telemetryFromCommandLine(commandLine, telemetry);
+    std::string algorithm = commandLine.get("algorithm", "clarke_wright");
+    if (findSolverEntry(algorithm) == nullptr) {
+        throw std::runtime_error("Unknown algorithm: " + algorithm);
+    }
+    std::vector<GeoPoint> points;
+    std::string coordinates = commandLine.has("sparse") ? commandLine.matrixFile : commandLine.get("coordinates");
+    if (!coordinates.empty()) {
+        points = readCoordinates(coordinates);
+    }
+    auto solve = [&](const auto& matrix) {
+        int numVehicles = commandLine.numVehicles;
+        Constraints constraints;
+        const Constraints* limits = constraintsFromCommandLine(commandLine, matrix, constraints);
+
+        DecomposeParams params;
+        params.clustering = commandLine.get("clusters", params.clustering);
+        params.clusterSize = commandLine.getNumber("cluster-size", params.clusterSize);
+        params.rounds = commandLine.getNumber("rounds", params.rounds);
+        params.threads = commandLine.getNumber("threads", params.threads);
+        params.neighbors = commandLine.getNumber("ls-neighbors", params.neighbors);
+        params.seed = commandLine.getNumber("seed", params.seed);
+        params.points = points.empty() ? nullptr : &points;
+        params.constraints = limits;
+        params.control = &control;
+
+        const SolverEntry<DistanceMatrix>& entry = *findSolverEntry(algorithm);
+        SubSolver subSolve = [&](const DistanceMatrix& sub, int vehicles, const Constraints* subLimits,
+                                 const SolveControl* subControl) {
+            return runSolverEntry(entry, sub, vehicles, subLimits, subControl, params.seed);
+        };
+        auto routes = timePhase(probe, "construct", [&] { return decomposeVRP(matrix, numVehicles, params, subSolve); });
+        reportRoutes(&control, matrix, routes);
+        warnViolations(limits, routes, matrix);
+        timePhase(probe, "write", [&] { writeRoutes(routes); });
+        writeTelemetry(commandLine, probe, "decompose", matrix);
+
+        return 0;
+    };
+    if (commandLine.has("sparse")) {
+        return solve(timePhase(probe, "parse", [&] { return sparseMatrixFromCommandLine(commandLine); }));
+    }
+    auto stored = timePhase(probe, "parse", [&] {
+        return loadDistanceMatrix(commandLine.matrixFile, commandLine.get("distance-type", "auto"));
+    });
+    return stored.visit(solve);
+} catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+}
@@ -0,0 +1,631 @@
+#ifndef DECOMPOSE_H
+#define DECOMPOSE_H
+
+#include "solvers.h"
+#include "local_search.h"
+#include "geo_matrix.h"
+#include <exception>
+#include <functional>
+#include <numeric>
+#include <random>
+
+// Tuning knobs for decomposeVRP
+struct DecomposeParams {
+    std::string clustering = "medoids";  // "medoids", "sweep" or "routes"
+    int clusterSize = 200;                // Target stops per sub-problem
+    int rounds = 3;                       // Boundary re-optimization rounds after stitching
+    int threads = 1;                      // Sub-problems solved at once
+    int neighbors = 20;                   // Candidate lists of the boundary local search
+    unsigned seed = 1;                    // Seeds the k-medoids start
+    const std::vector<GeoPoint>* points = nullptr;  // Coordinates, depot first; "sweep" needs them
+    const Constraints* constraints = nullptr;       // Handed to every sub-problem and kept when stitching
+    const SolveControl* control = nullptr;          // Its deadline is shared out among the sub-solves
+};
+
+// Solves one sub-problem: the depot plus a cluster's stops, numbered 1..k
+using SubSolver = std::function<std::vector<std::vector<int>>(const DistanceMatrix& matrix, int numVehicles,
+                                                               const Constraints* constraints,
+                                                               const SolveControl* control)>;
+
+// Dense matrix over the depot plus nodes (renumbered 1..k in the order
+// given), read from any distance provider
+template <typename Matrix>
+DistanceMatrix denseSubMatrix(const Matrix& matrix, const std::vector<int>& nodes) {
+    int k = nodes.size();
+    DistanceMatrix result(k);
+    for (int i = 0; i <= k; i++) {
+        int from = (i == 0) ? 0 : nodes[i - 1];
+        for (int j = 0; j <= k; j++) {
+            result.set(i, j, matrix(from, (j == 0) ? 0 : nodes[j - 1]));
+        }
+    }
+    result.setSymmetric(matrix.symmetric());
+    return result;
+}
+
+// The constraints of the depot plus nodes, numbered like denseSubMatrix
+inline Constraints subConstraints(const Constraints& constraints, const std::vector<int>& nodes) {
+    auto pick = [&](const std::vector<int>& values) {
+        std::vector<int> picked;
+        if (values.empty()) {
+            return picked;
+        }
+        picked.push_back(values[0]);
+        for (int node : nodes) {
+            picked.push_back(values[node]);
+        }
+        return picked;
+    };
+    Constraints result;
+    result.capacity = constraints.capacity;
+    result.demands = pick(constraints.demands);
+    result.ready = pick(constraints.ready);
+    result.due = pick(constraints.due);
+    result.service = pick(constraints.service);
+    return result;
+}
+
+// Stops of a route without the depot visits
+inline std::vector<int> routeStops(const std::vector<int>& route) {
+    std::vector<int> stops;
+    for (int node : route) {
+        if (node != 0) stops.push_back(node);
+    }
+    return stops;
+}
+
+// Clusters by bearing from the depot: stops sorted by angle and cut into
+// equal runs of about clusterSize, starting after the widest empty sector
+inline std::vector<int> sweepClusters(const std::vector<GeoPoint>& points, int clusterSize) {
+    const double PI = 3.14159265358979323846;
+    int n = int(points.size()) - 1;
+    double scale = std::cos(points[0].lat * PI / 180.0);
+    std::vector<std::pair<double, int>> bearing;
+    for (int i = 1; i <= n; i++) {
+        bearing.push_back({std::atan2(points[i].lat - points[0].lat, (points[i].lon - points[0].lon) * scale), i});
+    }
+    std::sort(bearing.begin(), bearing.end());
+    int start = 0;
+    double widest = -1.0;
+    for (int i = 0; i < n; i++) {
+        double gap = (i == 0) ? bearing[0].first + 2.0 * PI - bearing[n - 1].first
+                              : bearing[i].first - bearing[i - 1].first;
+        if (gap > widest) {
+            widest = gap;
+            start = i;
+        }
+    }
+    int k = (n + clusterSize - 1) / clusterSize;
+    std::vector<int> cluster(n + 1, -1);
+    for (int i = 0; i < n; i++) {
+        cluster[bearing[(start + i) % n].second] = int((long long)i * k / n);
+    }
+    return cluster;
+}
+
+// Balanced k-medoids on the matrix, k = N / clusterSize
+// Medoids start k-means++ style from a sample of 40 stops per medoid. Each
+// round then assigns every stop to the nearest of its 6 nearest medoids
+// that still has room (clusters hold at most 15% more than the mean, and
+// the stops with most to lose from their second choice pick first), and
+// moves each medoid to the sampled member closest to a sample of its
+// cluster. A sparse matrix finds the nearest medoids through its spatial
+// index, so a round costs O(N log k) there and O(N k) on a dense matrix.
+template <typename Matrix>
+std::vector<int> medoidClusters(const Matrix& matrix, int clusterSize, int threads, unsigned seed) {
+    const int CANDIDATES = 6;
+    const int ROUNDS = 3;
+    int n = matrix.customers();
+    int k = (n + clusterSize - 1) / clusterSize;
+    std::vector<int> cluster(n + 1, 0);
+    cluster[0] = -1;
+    if (k <= 1) {
+        return cluster;
+    }
+
+    std::mt19937 rng(seed);
+    std::vector<int> sample(n);
+    std::iota(sample.begin(), sample.end(), 1);
+    std::shuffle(sample.begin(), sample.end(), rng);
+    sample.resize(std::min<size_t>(n, size_t(k) * 40));
+    std::vector<int> medoids = {sample[0]};
+    std::vector<double> weight(sample.size(), std::numeric_limits<double>::infinity());
+    std::vector<char> chosen(sample.size(), 0);
+    chosen[0] = 1;
+    while (int(medoids.size()) < k) {
+        double total = 0.0;
+        for (size_t s = 0; s < sample.size(); s++) {
+            double d = matrix(medoids.back(), sample[s]);
+            weight[s] = chosen[s] ? 0.0 : std::min(weight[s], d * d);
+            total += weight[s];
+        }
+        size_t pick = 0;
+        if (total > 0.0) {
+            double target = std::uniform_real_distribution<double>(0.0, total)(rng);
+            while (pick + 1 < sample.size() && (chosen[pick] || (target -= weight[pick]) > 0.0)) {
+                pick++;
+            }
+        }
+        // Duplicated points leave nothing to weigh; take any unchosen stop
+        while (chosen[pick]) {
+            pick = (pick + 1) % sample.size();
+        }
+        chosen[pick] = 1;
+        medoids.push_back(sample[pick]);
+    }
+
+    std::vector<int> choice(size_t(n + 1) * CANDIDATES);
+    std::vector<int> choiceDistance(size_t(n + 1) * CANDIDATES);
+    auto assign = [&] {
+        std::vector<int> medoidOf(n + 1, -1);
+        for (int c = 0; c < k; c++) {
+            medoidOf[medoids[c]] = c;
+        }
+        std::fill(choice.begin(), choice.end(), -1);
+        auto record = [&](int node, int slot, int c, int d) {
+            choice[size_t(node) * CANDIDATES + slot] = c;
+            choiceDistance[size_t(node) * CANDIDATES + slot] = d;
+        };
+        if constexpr (Matrix::SPARSE) {
+            SpatialIndex alive = matrix.index();
+            for (int node = 1; node <= n; node++) {
+                if (medoidOf[node] < 0) alive.remove(node);
+            }
+            parallelFor(1, n + 1, threads, [&](int node) {
+                std::vector<std::pair<int, int>> found;
+                matrix.nearestIn(alive, node, CANDIDATES, [](int) { return true; }, found);
+                int slot = 0;
+                if (medoidOf[node] >= 0) {
+                    record(node, slot++, medoidOf[node], 0);
+                }
+                for (size_t f = 0; f < found.size() && slot < CANDIDATES; f++) {
+                    record(node, slot++, medoidOf[found[f].second], found[f].first);
+                }
+            });
+        } else {
+            parallelFor(1, n + 1, threads, [&](int node) {
+                std::vector<std::pair<int, int>> found(k);
+                for (int c = 0; c < k; c++) {
+                    found[c] = {matrix(medoids[c], node), c};
+                }
+                int count = std::min(k, CANDIDATES);
+                std::partial_sort(found.begin(), found.begin() + count, found.end());
+                for (int slot = 0; slot < count; slot++) {
+                    record(node, slot, found[slot].second, found[slot].first);
+                }
+            });
+        }
+
+        // Stops that lose most by missing their first choice pick first
+        auto regret = [&](int node) {
+            const int* d = choiceDistance.data() + size_t(node) * CANDIDATES;
+            return choice[size_t(node) * CANDIDATES + 1] < 0 ? std::numeric_limits<int>::max() : d[1] - d[0];
+        };
+        std::vector<int> order(n);
+        std::iota(order.begin(), order.end(), 1);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return regret(a) > regret(b); });
+        int room = int(std::ceil(1.15 * n / k));
+        std::vector<int> filled(k, 0);
+        for (int node : order) {
+            int target = -1;
+            for (int slot = 0; slot < CANDIDATES && target < 0; slot++) {
+                int c = choice[size_t(node) * CANDIDATES + slot];
+                if (c >= 0 && filled[c] < room) target = c;
+            }
+            // All near medoids are full: the nearest one with room
+            for (int c = 0; target < 0 && c < k; c++) {
+                if (filled[c] < room) target = c;
+            }
+            for (int c = target + 1; c < k; c++) {
+                if (filled[c] < room && matrix(medoids[c], node) < matrix(medoids[target], node)) target = c;
+            }
+            cluster[node] = target;
+            filled[target]++;
+        }
+    };
+
+    auto update = [&](int round) {
+        std::vector<std::vector<int>> members(k);
+        for (int node = 1; node <= n; node++) {
+            members[cluster[node]].push_back(node);
+        }
+        parallelFor(0, k, threads, [&](int c) {
+            if (members[c].empty()) {
+                return;
+            }
+            std::mt19937 local(seed + unsigned(c) * 7919u + unsigned(round));
+            std::vector<int> stops = members[c];
+            std::shuffle(stops.begin(), stops.end(), local);
+            std::vector<int> candidates(stops.begin(), stops.begin() + std::min<size_t>(stops.size(), 16));
+            candidates.push_back(medoids[c]);
+            size_t targets = std::min<size_t>(stops.size(), 48);
+            long long bestCost = std::numeric_limits<long long>::max();
+            for (int candidate : candidates) {
+                long long cost = 0;
+                for (size_t t = 0; t < targets; t++) {
+                    cost += matrix(candidate, stops[t]);
+                }
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    medoids[c] = candidate;
+                }
+            }
+        });
+    };
+
+    for (int round = 0; round < ROUNDS; round++) {
+        assign();
+        update(round);
+    }
+    assign();
+    return cluster;
+}
+
+// Non-empty routes in a chain: each next route is the remaining one whose
+// middle stop is nearest to the previous route's. On petal-shaped routes the
+// middle stop is the far end, which tells neighbouring routes apart better
+// than their ends (all near the depot).
+template <typename Matrix>
+std::vector<int> chainRoutes(const Matrix& matrix, const std::vector<std::vector<int>>& routes) {
+    std::vector<int> remaining, middle(routes.size(), -1);
+    for (size_t r = 0; r < routes.size(); r++) {
+        std::vector<int> stops = routeStops(routes[r]);
+        if (!stops.empty()) {
+            middle[r] = stops[stops.size() / 2];
+            remaining.push_back(int(r));
+        }
+    }
+    std::vector<int> chain;
+    while (!remaining.empty()) {
+        size_t next = 0;
+        if (!chain.empty()) {
+            int from = middle[chain.back()];
+            for (size_t i = 1; i < remaining.size(); i++) {
+                if (matrix(from, middle[remaining[i]]) < matrix(from, middle[remaining[next]])) next = i;
+            }
+        }
+        chain.push_back(remaining[next]);
+        remaining.erase(remaining.begin() + next);
+    }
+    return chain;
+}
+
+// Route-based regions of a solution: the stops of the chained routes, in
+// route order, cut into runs of clusterSize
+template <typename Matrix>
+std::vector<int> routeClusters(const Matrix& matrix, const std::vector<std::vector<int>>& routes, int clusterSize) {
+    std::vector<int> cluster(matrix.size(), -1);
+    int position = 0;
+    for (int r : chainRoutes(matrix, routes)) {
+        for (int stop : routeStops(routes[r])) {
+            cluster[stop] = position++ / clusterSize;
+        }
+    }
+    return cluster;
+}
+
+// Solve each group of stops as its own sub-problem, largest first on a work
+// stealing pool; routes come back in the original node numbers. With a
+// deadline, each solve gets an equal share of half the remaining time (the
+// rest is left for stitching and the boundary rounds); once the control
+// stops, the remaining groups only get nearest neighbor routes.
+template <typename Matrix>
+std::vector<std::vector<std::vector<int>>> solveGroups(const Matrix& matrix,
+                                                       const std::vector<std::vector<int>>& groups,
+                                                       const std::vector<int>& vehicles,
+                                                       const DecomposeParams& params, const SubSolver& solve) {
+    std::vector<std::vector<std::vector<int>>> results(groups.size());
+    std::vector<std::exception_ptr> errors(groups.size());
+    std::vector<int> order(groups.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return groups[a].size() > groups[b].size(); });
+
+    double share = std::numeric_limits<double>::infinity();
+    if (params.control != nullptr && params.control->hasDeadline() && !groups.empty()) {
+        int waves = (int(groups.size()) + std::max(1, params.threads) - 1) / std::max(1, params.threads);
+        share = 0.5 * params.control->remainingSeconds() / waves;
+    }
+    workStealingFor(order, params.threads, [&](int g, int) {
+        try {
+            DistanceMatrix sub = denseSubMatrix(matrix, groups[g]);
+            Constraints limits;
+            const Constraints* subLimits = nullptr;
+            if (params.constraints != nullptr) {
+                limits = subConstraints(*params.constraints, groups[g]);
+                subLimits = &limits;
+            }
+            std::vector<std::vector<int>> routes;
+            if (params.control != nullptr && params.control->stopRequested()) {
+                NearestNeighborParams quick;
+                quick.constraints = subLimits;
+                routes = nearestNeighborVRP(sub, vehicles[g], quick);
+            } else {
+                SolveControl control;
+                if (share < std::numeric_limits<double>::infinity()) {
+                    control.setTimeLimit(share);
+                }
+                routes = solve(sub, vehicles[g], subLimits, &control);
+            }
+            for (auto& route : routes) {
+                for (int& node : route) {
+                    node = (node == 0) ? 0 : groups[g][node - 1];
+                }
+            }
+            results[g] = std::move(routes);
+        } catch (...) {
+            errors[g] = std::current_exception();
+        }
+    });
+    for (const auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    return results;
+}
+
+// Join routes end to start until at most numVehicles are left, in the
+// order of the savings d(a, 0) + d(0, b) - d(a, b) of linking the last stop
+// a of one route to the first stop b of another (Clarke-Wright on whole
+// routes, with each tail's 32 best heads as candidates). With constraints a
+// join must not add violation, and routes that cannot be joined stay
+// separate, like the extra routes the constrained solvers open. The result
+// is padded with empty routes to numVehicles.
+template <typename Matrix>
+std::vector<std::vector<int>> stitchRoutes(const Matrix& matrix, const std::vector<std::vector<int>>& routes,
+                                           int numVehicles, const Constraints* constraints) {
+    const int CANDIDATES = 32;
+    std::vector<std::vector<int>> stops;
+    for (const auto& route : routes) {
+        std::vector<int> inner = routeStops(route);
+        if (!inner.empty()) stops.push_back(std::move(inner));
+    }
+    int count = stops.size();
+    std::vector<int> next(count, -1), previous(count, -1), chain(count);
+    std::iota(chain.begin(), chain.end(), 0);
+    auto find = [&](int r) {
+        while (chain[r] != r) r = chain[r] = chain[chain[r]];
+        return r;
+    };
+    auto chainStops = [&](int head) {
+        std::vector<int> joined;
+        for (int r = head; r >= 0; r = next[r]) {
+            joined.insert(joined.end(), stops[r].begin(), stops[r].end());
+        }
+        return joined;
+    };
+    auto chainHead = [&](int r) {
+        while (previous[r] >= 0) r = previous[r];
+        return r;
+    };
+
+    struct Saving {
+        long long value;
+        int tail, head;
+        bool operator<(const Saving& other) const {
+            return value != other.value ? value > other.value
+                                        : (tail != other.tail ? tail < other.tail : head < other.head);
+        }
+    };
+    int routesLeft = count;
+    if (routesLeft > numVehicles) {
+        std::vector<Saving> savings;
+        for (int a = 0; a < count; a++) {
+            int last = stops[a].back();
+            std::vector<Saving> row;
+            for (int b = 0; b < count; b++) {
+                if (a == b) continue;
+                int first = stops[b].front();
+                row.push_back({(long long)matrix(last, 0) + matrix(0, first) - matrix(last, first), a, b});
+            }
+            int keep = std::min<int>(row.size(), CANDIDATES);
+            std::partial_sort(row.begin(), row.begin() + keep, row.end());
+            savings.insert(savings.end(), row.begin(), row.begin() + keep);
+        }
+        std::sort(savings.begin(), savings.end());
+        for (const auto& saving : savings) {
+            if (routesLeft <= numVehicles) break;
+            int a = saving.tail, b = saving.head;
+            if (next[a] >= 0 || previous[b] >= 0 || find(a) == find(b)) continue;
+            if (constraints != nullptr) {
+                int headA = chainHead(a);
+                std::vector<int> first = chainStops(headA), second = chainStops(b);
+                std::vector<int> joined = first;
+                joined.insert(joined.end(), second.begin(), second.end());
+                if (constraints->violation(constraints->route(joined, matrix)) >
+                    constraints->violation(constraints->route(first, matrix)) +
+                        constraints->violation(constraints->route(second, matrix))) {
+                    continue;
+                }
+            }
+            next[a] = b;
+            previous[b] = a;
+            chain[find(b)] = find(a);
+            routesLeft--;
+        }
+    }
+
+    std::vector<std::vector<int>> result;
+    for (int r = 0; r < count; r++) {
+        if (previous[r] >= 0) continue;
+        std::vector<int> route = {0};
+        std::vector<int> joined = chainStops(r);
+        route.insert(route.end(), joined.begin(), joined.end());
+        route.push_back(0);
+        result.push_back(std::move(route));
+    }
+    while (int(result.size()) < numVehicles) {
+        result.push_back({0, 0});
+    }
+    return result;
+}
+
+// One boundary round: chained routes are grouped into regions of at most
+// clusterSize stops (the first region is cut short on odd rounds, so the
+// seams move between rounds) and each region is solved again with as many
+// vehicles as it has routes; a region's new routes replace the old ones
+// only when they add no violation and cost less. Routes longer than
+// clusterSize are left to the local search. Returns each stop's region.
+template <typename Matrix>
+std::vector<int> resolveRegions(const Matrix& matrix, std::vector<std::vector<int>>& routes, int numVehicles,
+                                const DecomposeParams& params, const SubSolver& solve, int round) {
+    int clusterSize = std::max(2, params.clusterSize);
+    std::vector<int> region(matrix.size(), -1);
+    std::vector<std::vector<int>> groups, members;   // Stops and route indices of each region
+    int limit = (round % 2 == 1) ? clusterSize / 2 : clusterSize;
+    int oversized = matrix.size();   // Labels of the routes left alone, past any region's
+    for (int r : chainRoutes(matrix, routes)) {
+        std::vector<int> stops = routeStops(routes[r]);
+        if (int(stops.size()) > clusterSize) {
+            for (int stop : stops) region[stop] = oversized;
+            oversized++;
+            continue;
+        }
+        if (groups.empty() || int(groups.back().size() + stops.size()) > limit) {
+            if (!groups.empty()) limit = clusterSize;
+            groups.emplace_back();
+            members.emplace_back();
+        }
+        groups.back().insert(groups.back().end(), stops.begin(), stops.end());
+        members.back().push_back(r);
+    }
+    for (size_t g = 0; g < groups.size(); g++) {
+        for (int stop : groups[g]) region[stop] = int(g);
+    }
+
+    std::vector<int> vehicles;
+    for (const auto& group : members) {
+        vehicles.push_back(int(group.size()));
+    }
+    auto results = solveGroups(matrix, groups, vehicles, params, solve);
+
+    std::vector<std::vector<int>> improved;
+    std::vector<char> replaced(routes.size(), 0);
+    for (size_t g = 0; g < groups.size(); g++) {
+        std::vector<std::vector<int>> before;
+        for (int r : members[g]) before.push_back(routes[r]);
+        const auto& after = results[g];
+        int used = 0;
+        for (const auto& route : after) {
+            if (!routeStops(route).empty()) used++;
+        }
+        long long oldCost = calculateTotalDistance(before, matrix), newCost = calculateTotalDistance(after, matrix);
+        int oldViolation = params.constraints != nullptr ? params.constraints->violation(before, matrix) : 0;
+        int newViolation = params.constraints != nullptr ? params.constraints->violation(after, matrix) : 0;
+        if (used <= int(members[g].size()) && newViolation <= oldViolation && newCost < oldCost) {
+            for (int r : members[g]) replaced[r] = 1;
+            improved.insert(improved.end(), after.begin(), after.end());
+        }
+    }
+    std::vector<std::vector<int>> result;
+    for (size_t r = 0; r < routes.size(); r++) {
+        if (!replaced[r] && !routeStops(routes[r]).empty()) result.push_back(routes[r]);
+    }
+    for (auto& route : improved) {
+        if (!routeStops(route).empty()) result.push_back(std::move(route));
+    }
+    while (int(result.size()) < numVehicles) {
+        result.push_back({0, 0});
+    }
+    routes = std::move(result);
+    return region;
+}
+
+// Cluster-first, route-second solve for instances too large for one search
+// Stops are split into clusters of about clusterSize: "sweep" by bearing from
+// the depot (needs points), "medoids" by balanced k-medoids on the matrix, or
+// "routes" as route-based regions of a nearest neighbor solution. Each cluster
+// is solved with solve on its own dense sub-matrix, in parallel, with the
+// fleet shared out by cluster size (at least one vehicle each); the routes
+// are then stitched down to numVehicles. Each boundary round first (from the
+// second round on) re-solves regions of neighbouring routes, then runs the
+// local search from the stops whose nearest neighbours lie in another
+// cluster or region. Sub-problems have a fixed size, so the work grows about
+// linearly with N (plus O(N k) for the medoids of a dense matrix).
+template <typename Matrix>
+std::vector<std::vector<int>> decomposeVRP(const Matrix& matrix, int numVehicles, const DecomposeParams& params,
+                                           const SubSolver& solve) {
+    int n = matrix.customers();
+    int clusterSize = std::max(2, params.clusterSize);
+    DecomposeParams settings = params;
+    if (settings.constraints != nullptr && !settings.constraints->active()) {
+        settings.constraints = nullptr;
+    }
+
+    std::vector<int> label;
+    if (params.clustering == "sweep") {
+        if (params.points == nullptr || int(params.points->size()) != matrix.size()) {
+            throw std::runtime_error("Sweep clustering needs the coordinates of every node");
+        }
+        label = sweepClusters(*params.points, clusterSize);
+    } else if (params.clustering == "medoids") {
+        label = medoidClusters(matrix, clusterSize, params.threads, params.seed);
+    } else if (params.clustering == "routes") {
+        NearestNeighborParams quick;
+        quick.threads = params.threads;
+        quick.constraints = settings.constraints;
+        label = routeClusters(matrix, nearestNeighborVRP(matrix, numVehicles, quick), clusterSize);
+    } else {
+        throw std::runtime_error("Unknown clustering: " + params.clustering);
+    }
+
+    // Fleet shared by cluster size, largest remainders first
+    int numClusters = 0;
+    for (int node = 1; node <= n; node++) {
+        numClusters = std::max(numClusters, label[node] + 1);
+    }
+    std::vector<std::vector<int>> clusters(numClusters);
+    for (int node = 1; node <= n; node++) {
+        clusters[label[node]].push_back(node);
+    }
+    clusters.erase(std::remove_if(clusters.begin(), clusters.end(), [](const std::vector<int>& c) { return c.empty(); }),
+                   clusters.end());
+    std::vector<int> vehicles(clusters.size(), 1);
+    int spare = numVehicles - int(clusters.size());
+    if (spare > 0) {
+        std::vector<std::pair<double, int>> remainders;
+        for (size_t c = 0; c < clusters.size(); c++) {
+            double exact = double(spare) * clusters[c].size() / n;
+            vehicles[c] += int(exact);
+            remainders.push_back({int(exact) - exact, int(c)});
+        }
+        std::sort(remainders.begin(), remainders.end());
+        int left = spare;
+        for (int v : vehicles) left -= v - 1;
+        for (int i = 0; i < left; i++) vehicles[remainders[i].second]++;
+    }
+
+    std::vector<std::vector<int>> routes;
+    for (auto& solved : solveGroups(matrix, clusters, vehicles, settings, solve)) {
+        routes.insert(routes.end(), solved.begin(), solved.end());
+    }
+    routes = stitchRoutes(matrix, routes, numVehicles, settings.constraints);
+
+    NeighborLists lists(matrix, params.neighbors, params.threads);
+    for (int round = 0; round < params.rounds; round++) {
+        if (params.control != nullptr && params.control->stopRequested()) {
+            break;
+        }
+        if (round > 0) {
+            label = resolveRegions(matrix, routes, numVehicles, settings, solve, round);
+        }
+        std::vector<int> boundary;
+        for (int node = 1; node <= n; node++) {
+            const int* near = lists.of(node);
+            for (int c = 0; c < std::min(lists.k(), 8); c++) {
+                if (label[near[c]] != label[node]) {
+                    boundary.push_back(node);
+                    break;
+                }
+            }
+        }
+        LocalSearchParams search;
+        search.neighbors = params.neighbors;
+        search.index = &lists;
+        search.focus = &boundary;
+        search.control = params.control;
+        search.constraints = settings.constraints;
+        routes = localSearchVRP(matrix, routes, search);
+    }
+    return routes;
+}
+
+#endif
@@ -0,0 +1,444 @@
+#ifndef GENETIC_ALGORITHM_H
+#define GENETIC_ALGORITHM_H
+
+#include "common.h"
+#include "parallel.h"
+#include "route_cost.h"
+#include "telemetry.h"
+#include "control.h"
+
+// Tuning knobs for geneticAlgorithmVRP
+struct GeneticParams {
+    int populationSize = 50;         // Individuals per island
+    int generations = 100;           // <= 0 runs until control stops the search
+    double mutationRate = 0.2;
+    double crossoverRate = 0.8;
+    unsigned seed = 0;               // 0 seeds from the clock
+    int islands = 1;                 // One thread and one population per island
+    int migrationInterval = 10;      // Generations between migrations
+    int migrants = 2;                // Elites each island sends per migration
+    std::string topology = "ring";   // "ring", "bidirectional" or "full"
+    int evaluationThreads = 1;       // Fitness batches per generation when islands == 1
+    CostKernel costKernel = CostKernel::Automatic;
+    Telemetry* telemetry = nullptr;  // Phase times, throughput and per-generation diversity
+    const SolveControl* control = nullptr; // Deadline/cancellation and streamed improvements
+    const Incumbent* incumbent = nullptr;  // Shared best of a race; joins each island when it is better
+};
+
+// One GA population evolving on its own RNG stream
+// Both generations live in a single arena of 2 * populationSize * n ints and
+// swap roles every generation; crossover, mutation and fitness decoding all
+// work on that storage, so the generation loop does not allocate.
+template <typename Matrix>
+class GeneticIsland {
+public:
+    GeneticIsland(const Matrix& matrix, int numVehicles, const GeneticParams& params, unsigned seed, int islandIndex)
+        : matrix(matrix), numVehicles(numVehicles), params(params), n(matrix.customers()),
+          populationSize(std::max(1, params.populationSize)) {
+        std::seed_seq seeds{seed, unsigned(islandIndex)};
+        gen.seed(seeds);
+
+        arena.resize(size_t(2) * populationSize * n);
+        distances.assign(populationSize, 0);
+        cumulativeFitness.assign(populationSize, 0.0);
+        order.resize(populationSize);
+        inChild.assign(n + 1, 0);
+        bestIndividual.resize(n);
+
+        // Every individual is split into the same numVehicles chunks, so the
+        // route layout is shared by the whole population
+        int nodesPerVehicle = n / numVehicles;
+        int extraNodes = n % numVehicles;
+        int end = 0;
+        for (int v = 0; v < numVehicles; v++) {
+            end += nodesPerVehicle + (v < extraNodes ? 1 : 0);
+            routeEnds.push_back(end);
+        }
+
+        // Initialize population (random permutations of nodes 1 to n)
+        for (int p = 0; p < populationSize; p++) {
+            int* individual = member(p);
+            for (int i = 0; i < n; i++) {
+                individual[i] = i + 1;
+            }
+            std::shuffle(individual, individual + n, gen);
+        }
+    }
+
+    // Score every individual with the batch cost kernel, split into one
+    // contiguous batch per thread when threads > 1
+    void evaluate(int threads) {
+        int batches = std::max(1, std::min(threads, populationSize));
+        parallelFor(0, batches, batches, [&](int b) {
+            int begin = int((long long)populationSize * b / batches);
+            int end = int((long long)populationSize * (b + 1) / batches);
+            batchRouteDistances(matrix, member(begin), end - begin, n, routeEnds,
+                                distances.data() + begin, params.costKernel);
+        });
+        for (int i = 0; i < populationSize; i++) {
+            if (distances[i] < bestDistance) {
+                bestDistance = distances[i];
+                std::copy(member(i), member(i) + n, bestIndividual.begin());
+            }
+        }
+    }
+
+    // Selection, crossover and mutation into the next generation
+    void evolve() {
+        // Roulette wheel over fitness = 1 / (distance + 1), kept as a
+        // running sum so selection is a binary search
+        double total = 0.0;
+        for (int i = 0; i < populationSize; i++) {
+            total += 1.0 / (distances[i] + 1); // Add 1 to avoid division by zero
+            cumulativeFitness[i] = total;
+        }
+        std::uniform_real_distribution<> spin(0.0, total);
+        auto select = [&]() {
+            int idx = std::upper_bound(cumulativeFitness.begin(), cumulativeFitness.end(), spin(gen))
+                    - cumulativeFitness.begin();
+            return member(std::min(idx, populationSize - 1));
+        };
+
+        int nextBase = currentBase == 0 ? populationSize : 0;
+        auto child = [&](int p) { return arena.data() + size_t(nextBase + p) * n; };
+
+        // Elitism: keep the best individual
+        std::copy(bestIndividual.begin(), bestIndividual.end(), child(0));
+
+        for (int p = 1; p < populationSize; p++) {
+            const int* parent1 = select();
+            const int* parent2 = select();
+
+            crossover(parent1, parent2, child(p));
+            mutate(child(p));
+        }
+
+        currentBase = nextBase;
+    }
+
+    int best() const { return bestDistance; }
+
+    // Population statistics of the last evaluation: mean distance, share of
+    // distinct distances and mean share of positions that differ from the best tour
+    TelemetryRow snapshot(int island, int generation) const {
+        double mean = 0.0, differing = 0.0;
+        std::vector<int> sorted(distances);
+        std::sort(sorted.begin(), sorted.end());
+        int distinct = std::unique(sorted.begin(), sorted.end()) - sorted.begin();
+        for (int p = 0; p < populationSize; p++) {
+            mean += distances[p];
+            const int* individual = member(p);
+            for (int i = 0; i < n; i++) {
+                differing += individual[i] != bestIndividual[i];
+            }
+        }
+        mean /= populationSize;
+        return {{"island", island}, {"generation", generation}, {"best", bestDistance}, {"mean", mean},
+                {"distinct_fitness", double(distinct) / populationSize},
+                {"diversity", n > 0 ? differing / (double(populationSize) * n) : 0.0}};
+    }
+
+    const std::vector<int>& bestTour() const { return bestIndividual; }
+
+    // Copies of the k fittest individuals of the last evaluation
+    std::vector<std::pair<std::vector<int>, int>> emigrants(int k) {
+        rankPopulation();
+        std::vector<std::pair<std::vector<int>, int>> result;
+        for (int i = 0; i < k && i < populationSize; i++) {
+            result.emplace_back(std::vector<int>(member(order[i]), member(order[i]) + n), distances[order[i]]);
+        }
+        return result;
+    }
+
+    // Replace the least fit individuals with arrivals from other islands
+    void immigrate(const std::vector<std::pair<std::vector<int>, int>>& arrivals) {
+        rankPopulation();
+        for (size_t i = 0; i < arrivals.size() && i + 1 < order.size(); i++) {
+            int slot = order[order.size() - 1 - i];
+            std::copy(arrivals[i].first.begin(), arrivals[i].first.end(), member(slot));
+            distances[slot] = arrivals[i].second;
+            if (arrivals[i].second < bestDistance) {
+                bestDistance = arrivals[i].second;
+                bestIndividual = arrivals[i].first;
+            }
+        }
+    }
+
+    // Put the shared incumbent in the last slot when a new one beats this
+    // island's best. Called between evolve() and evaluate(), when distances
+    // still describe the previous generation, so the slot is fixed rather than
+    // ranked; slot 0 holds the elite. Its stops are read route after route as
+    // one permutation, so the equal split may price it above the incumbent.
+    void follow(const Incumbent& incumbent) {
+        unsigned version = incumbent.version();
+        if (version == seenVersion) {
+            return;
+        }
+        seenVersion = version;
+        Incumbent::Solution shared;
+        if (incumbent.distance() >= bestDistance || !incumbent.read(shared)) {
+            return;
+        }
+        int* individual = member(populationSize - 1);
+        int position = 0;
+        for (const auto& route : shared.routes) {
+            for (int node : route) {
+                if (node != 0 && position < n) individual[position++] = node;
+            }
+        }
+    }
+
+    // Convert an individual to routes by splitting the permutation into numVehicles parts
+    std::vector<std::vector<int>> toRoutes(const std::vector<int>& individual) const {
+        std::vector<std::vector<int>> routes(numVehicles);
+        int nodesPerVehicle = n / numVehicles;
+        int extraNodes = n % numVehicles;
+
+        int index = 0;
+        for (int v = 0; v < numVehicles; v++) {
+            routes[v].push_back(0); // Start at depot
+
+            int nodesToAdd = nodesPerVehicle + (v < extraNodes ? 1 : 0);
+            for (int i = 0; i < nodesToAdd && index < n; i++) {
+                routes[v].push_back(individual[index++]);
+            }
+
+            routes[v].push_back(0); // Return to depot
+        }
+
+        return routes;
+    }
+
+private:
+    const Matrix& matrix;
+    int numVehicles;
+    const GeneticParams& params;
+    int n;
+    int populationSize;
+    std::mt19937 gen;
+    std::uniform_real_distribution<> realDist{0.0, 1.0};
+    std::vector<int> arena;
+    int currentBase = 0; // Index of the first current-generation slot in the arena
+    std::vector<int> distances;
+    std::vector<double> cumulativeFitness;
+    std::vector<int> order;
+    std::vector<char> inChild;
+    std::vector<int> bestIndividual;
+    std::vector<int> routeEnds;     // Where each vehicle's chunk of an individual ends
+    int bestDistance = std::numeric_limits<int>::max();
+    unsigned seenVersion = 0;       // Incumbent version last looked at
+
+    int* member(int p) { return arena.data() + size_t(currentBase + p) * n; }
+
+    const int* member(int p) const { return arena.data() + size_t(currentBase + p) * n; }
+
+    int randomIndex() {
+        return std::uniform_int_distribution<>(0, n - 1)(gen);
+    }
+
+    void rankPopulation() {
+        for (int i = 0; i < populationSize; i++) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return distances[a] < distances[b]; });
+    }
+
+    // Crossover (Order Crossover - OX)
+    // Positions outside a random slice of parent1 are filled with the
+    // remaining nodes in parent2's order; a membership bitmap keeps it O(n)
+    void crossover(const int* parent1, const int* parent2, int* child) {
+        if (realDist(gen) > params.crossoverRate) {
+            std::copy(parent1, parent1 + n, child); // No crossover
+            return;
+        }
+
+        // Select random subsequence from parent1
+        int start = randomIndex();
+        int end = randomIndex();
+        if (start > end) std::swap(start, end);
+
+        // Copy subsequence from parent1 to child
+        for (int i = start; i <= end; i++) {
+            child[i] = parent1[i];
+            inChild[parent1[i]] = 1;
+        }
+
+        // Fill remaining positions with values from parent2 in order
+        int j = 0;
+        for (int i = 0; i < n; i++) {
+            if (i == start) {
+                i = end;
+                continue;
+            }
+            while (inChild[parent2[j]]) {
+                j++;
+            }
+            child[i] = parent2[j++];
+        }
+
+        for (int i = start; i <= end; i++) {
+            inChild[parent1[i]] = 0;
+        }
+    }
+
+    // Mutation (Swap Mutation)
+    void mutate(int* individual) {
+        if (realDist(gen) < params.mutationRate) {
+            int pos1 = randomIndex();
+            int pos2 = randomIndex();
+            std::swap(individual[pos1], individual[pos2]);
+        }
+    }
+};
+
+// Islands each island i sends its elites to under the given topology
+inline std::vector<int> migrationTargets(const std::string& topology, int island, int numIslands) {
+    std::vector<int> targets;
+    if (topology == "full") {
+        for (int j = 0; j < numIslands; j++) {
+            if (j != island) targets.push_back(j);
+        }
+    } else {
+        targets.push_back((island + 1) % numIslands);
+        if (topology == "bidirectional" && numIslands > 2) {
+            targets.push_back((island + numIslands - 1) % numIslands);
+        }
+    }
+    return targets;
+}
+
+// Genetic Algorithm for VRP
+// Island model: params.islands populations evolve on their own threads and,
+// every migrationInterval generations, meet at a barrier where each island's
+// elites replace the weakest individuals of its neighbours in the topology.
+// Migration is deterministic and every island has its own RNG stream, so a
+// fixed seed reproduces the same result.
+// With params.control the islands stop early at the deadline or on
+// cancellation (islands that notice first idle until the next migration
+// barrier, so all of them leave together) and every new best is streamed.
+// With params.incumbent each island takes in the shared solution before an
+// evaluation whenever it has improved past the island's best.
+template <typename Matrix>
+std::vector<std::vector<int>> geneticAlgorithmVRP(const Matrix& matrix, int numVehicles, const GeneticParams& params) {
+    if (params.generations <= 0 && params.control == nullptr) {
+        throw std::runtime_error("Unbounded generations need a time limit or other stop control");
+    }
+    unsigned seed = params.seed != 0 ? params.seed : unsigned(std::time(0));
+    int numIslands = std::max(1, params.islands);
+    int evaluationThreads = numIslands == 1 ? params.evaluationThreads : 1;
+
+    Telemetry* telemetry = params.telemetry;
+    std::vector<GeneticIsland<Matrix>> islands;
+    islands.reserve(numIslands);
+    timePhase(telemetry, "construct", [&] {
+        for (int i = 0; i < numIslands; i++) {
+            islands.emplace_back(matrix, numVehicles, params, seed, i);
+        }
+    });
+    std::vector<std::vector<TelemetryRow>> generationTrace(numIslands);
+    int migrations = 0;
+    std::atomic<bool> stopping(false);
+    std::vector<long long> generationsRun(numIslands, 0);
+
+    auto migrate = [&]() {
+        migrations++;
+        std::vector<std::vector<std::pair<std::vector<int>, int>>> incoming(numIslands);
+        for (int i = 0; i < numIslands; i++) {
+            auto elites = islands[i].emigrants(params.migrants);
+            for (int target : migrationTargets(params.topology, i, numIslands)) {
+                incoming[target].insert(incoming[target].end(), elites.begin(), elites.end());
+            }
+        }
+        for (int i = 0; i < numIslands; i++) {
+            islands[i].immigrate(incoming[i]);
+        }
+    };
+
+    auto runIsland = [&](int i, Barrier* barrier) {
+        bool unbounded = params.generations <= 0;
+        for (int generation = 0; unbounded || generation < params.generations; generation++) {
+            bool migrationPoint = barrier != nullptr && params.migrationInterval > 0 &&
+                                  (generation + 1) % params.migrationInterval == 0;
+            if (!stopping) {
+                int previousBest = islands[i].best();
+                if (params.incumbent != nullptr) {
+                    islands[i].follow(*params.incumbent);
+                }
+                islands[i].evaluate(evaluationThreads);
+                generationsRun[i]++;
+                if (telemetry != nullptr) {
+                    generationTrace[i].push_back(islands[i].snapshot(i, generation));
+                }
+                if (params.control != nullptr && params.control->wantsImprovements() &&
+                    islands[i].best() < previousBest) {
+                    params.control->reportImprovement(islands[i].toRoutes(islands[i].bestTour()), islands[i].best());
+                }
+                if (stopRequested(params.control)) {
+                    stopping = true;
+                }
+            }
+            if (migrationPoint) {
+                barrier->arriveAndWait(migrate);
+            }
+            // Without migration barriers ahead an island may leave on its own
+            if (stopping && (migrationPoint || barrier == nullptr || params.migrationInterval <= 0)) {
+                break;
+            }
+            if (!stopping && (unbounded || generation + 1 < params.generations)) {
+                islands[i].evolve();
+            }
+        }
+    };
+
+    auto searchStart = std::chrono::steady_clock::now();
+    timePhase(telemetry, "search", [&] {
+        if (numIslands == 1) {
+            runIsland(0, nullptr);
+        } else {
+            Barrier barrier(numIslands);
+            std::vector<std::thread> threads;
+            for (int i = 0; i < numIslands; i++) {
+                threads.emplace_back(runIsland, i, &barrier);
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+    });
+    std::chrono::duration<double> searchTime = std::chrono::steady_clock::now() - searchStart;
+
+    int bestIsland = 0;
+    for (int i = 1; i < numIslands; i++) {
+        if (islands[i].best() < islands[bestIsland].best()) {
+            bestIsland = i;
+        }
+    }
+
+    if (telemetry != nullptr) {
+        double seconds = std::max(searchTime.count(), 1e-9);
+        long long generations = *std::max_element(generationsRun.begin(), generationsRun.end());
+        double evaluations = 0.0;
+        for (long long run : generationsRun) {
+            evaluations += double(run) * std::max(1, params.populationSize);
+        }
+        telemetry->setCounter("islands", numIslands);
+        telemetry->setCounter("generations", generations);
+        telemetry->setCounter("generations_per_sec", generations / seconds);
+        telemetry->setCounter("evaluations_per_sec", evaluations / seconds);
+        telemetry->setCounter("migrations", migrations);
+        telemetry->setCounter("best_distance", islands[bestIsland].best());
+        for (auto& rows : generationTrace) {
+            for (auto& row : rows) telemetry->addSample("generations", std::move(row));
+        }
+    }
+
+    // Convert best individual to routes
+    return islands[bestIsland].toRoutes(islands[bestIsland].bestTour());
+}
+
+template <typename Matrix>
+std::vector<std::vector<int>> geneticAlgorithmVRP(const Matrix& matrix, int numVehicles) {
+    return geneticAlgorithmVRP(matrix, numVehicles, GeneticParams());
+}
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef GEO_MATRIX_H
+#define GEO_MATRIX_H
+
+#include "common.h"
+#include "parallel.h"
+#include <sstream>
+
+// Mean Earth radius (IUGG), so distances come out in meters like OSRM's
+const double EARTH_RADIUS_METERS = 6371008.8;
+
+struct GeoPoint {
+    double lat;
+    double lon;
+};
+
+// Read one "lat lon" (or "lat,lon") pair per line, depot first; '#' starts a comment
+inline std::vector<GeoPoint> readCoordinates(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening coordinates file: " + filename);
+    }
+    std::vector<GeoPoint> points;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+        GeoPoint point;
+        if (fields >> point.lat >> point.lon) {
+            points.push_back(point);
+        } else if (line.find_first_not_of(" \t\r") != std::string::npos) {
+            throw std::runtime_error("Error: malformed coordinates in " + filename + ": " + line);
+        }
+    }
+    if (points.size() < 2) {
+        throw std::runtime_error("Error: " + filename + " needs the depot and at least one delivery point");
+    }
+    return points;
+}
+
+// Great-circle (haversine) distances in meters
+// Every point becomes a unit vector once. A row then takes the chord length
+// to every other point in a branch-free loop over flat x/y/z arrays, which
+// the compiler vectorizes, and converts chords to arcs in a second pass:
+// haversine's sqrt(a) is exactly half the chord, so d = 2R asin(c / 2).
+// Rows are split across threads.
+inline DistanceMatrix haversineMatrix(const std::vector<GeoPoint>& points, int threads) {
+    int size = points.size();
+    std::vector<double> x(size), y(size), z(size);
+    const double DEGREES = 3.14159265358979323846 / 180.0;
+    for (int i = 0; i < size; i++) {
+        double lat = points[i].lat * DEGREES, lon = points[i].lon * DEGREES;
+        x[i] = std::cos(lat) * std::cos(lon);
+        y[i] = std::cos(lat) * std::sin(lon);
+        z[i] = std::sin(lat);
+    }
+
+    DistanceMatrix matrix(size - 1);
+    parallelFor(0, size, threads, [&](int i) {
+        std::vector<double> half(size);
+        const double xi = x[i], yi = y[i], zi = z[i];
+        const double* xs = x.data();
+        const double* ys = y.data();
+        const double* zs = z.data();
+        double* out = half.data();
+        for (int j = 0; j < size; j++) {
+            double dx = xs[j] - xi, dy = ys[j] - yi, dz = zs[j] - zi;
+            out[j] = std::min(0.5 * std::sqrt(dx * dx + dy * dy + dz * dz), 1.0);
+        }
+        for (int j = 0; j < size; j++) {
+            matrix.set(i, j, int(std::lround(2.0 * EARTH_RADIUS_METERS * std::asin(out[j]))));
+        }
+    });
+    matrix.setSymmetric(true);
+    return matrix;
+}
+
+// Equirectangular approximation in meters
+// Points are projected once onto a plane through the mean latitude, after
+// which a row is plain Euclidean distances: one vectorized sqrt per entry
+// and no trigonometry. Across a city or metro area the error stays well
+// under 1%; use haversine for regional or wider spreads.
+inline DistanceMatrix equirectangularMatrix(const std::vector<GeoPoint>& points, int threads) {
+    int size = points.size();
+    const double DEGREES = 3.14159265358979323846 / 180.0;
+    double meanLat = 0.0;
+    for (const auto& point : points) {
+        meanLat += point.lat;
+    }
+    double scale = std::cos(meanLat / size * DEGREES);
+    std::vector<double> x(size), y(size);
+    for (int i = 0; i < size; i++) {
+        x[i] = EARTH_RADIUS_METERS * points[i].lon * DEGREES * scale;
+        y[i] = EARTH_RADIUS_METERS * points[i].lat * DEGREES;
+    }
+
+    DistanceMatrix matrix(size - 1);
+    parallelFor(0, size, threads, [&](int i) {
+        const double xi = x[i], yi = y[i];
+        const double* xs = x.data();
+        const double* ys = y.data();
+        int* out = matrix.row(i);
+        for (int j = 0; j < size; j++) {
+            double dx = xs[j] - xi, dy = ys[j] - yi;
+            out[j] = int(std::sqrt(dx * dx + dy * dy) + 0.5);
+        }
+    });
+    matrix.setSymmetric(true);
+    return matrix;
+}
+
+#endif
@@ -0,0 +1,284 @@
+#ifndef INSTANCES_H
+#define INSTANCES_H
+
+#include "common.h"
+#include "parallel.h"
+#include <sstream>
+
+// A benchmark instance: the distance matrix plus whatever the source file
+// says about the problem. Depot is node 0; other nodes keep file order.
+struct Instance {
+    std::string name;
+    DistanceMatrix matrix;
+    std::vector<int> demands;     // demands[0] is the depot's; empty for plain TSP files
+    int capacity = 0;             // 0 when the file has none
+    int vehicles = 0;             // 0 when the file does not say
+    long long bestKnown = -1;     // Best known total distance, -1 when unknown
+};
+
+// Bytes a dense matrix for numCustomers delivery points would take
+inline size_t matrixBytes(int numCustomers) {
+    return size_t(numCustomers + 1) * DistanceMatrix::paddedStride(numCustomers + 1) * sizeof(int);
+}
+
+// TSPLIB distance functions over node coordinates (TSPLIB 95, section 2)
+inline int tsplibDistance(const std::string& type, double x1, double y1, double x2, double y2) {
+    double dx = x1 - x2, dy = y1 - y2;
+    if (type == "EUC_2D") {
+        return int(std::sqrt(dx * dx + dy * dy) + 0.5);
+    }
+    if (type == "CEIL_2D") {
+        return int(std::ceil(std::sqrt(dx * dx + dy * dy)));
+    }
+    if (type == "MAN_2D") {
+        return int(std::abs(dx) + std::abs(dy) + 0.5);
+    }
+    if (type == "MAX_2D") {
+        return std::max(int(std::abs(dx) + 0.5), int(std::abs(dy) + 0.5));
+    }
+    if (type == "ATT") {
+        double r = std::sqrt((dx * dx + dy * dy) / 10.0);
+        int t = int(r + 0.5);
+        return t < r ? t + 1 : t;
+    }
+    if (type == "GEO") {
+        // Coordinates are DDD.MM degrees and minutes
+        const double PI = 3.141592;
+        const double RRR = 6378.388;
+        auto radians = [&](double value) {
+            int degrees = int(value);
+            return PI * (degrees + 5.0 * (value - degrees) / 3.0) / 180.0;
+        };
+        double lat1 = radians(x1), lon1 = radians(y1), lat2 = radians(x2), lon2 = radians(y2);
+        double q1 = std::cos(lon1 - lon2);
+        double q2 = std::cos(lat1 - lat2);
+        double q3 = std::cos(lat1 + lat2);
+        return int(RRR * std::acos(0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0);
+    }
+    throw std::runtime_error("Unsupported EDGE_WEIGHT_TYPE: " + type);
+}
+
+// Fill a matrix from coordinates, node order[i] becoming matrix node i
+inline DistanceMatrix coordinateMatrix(const std::vector<double>& x, const std::vector<double>& y,
+                                       const std::vector<int>& order, const std::string& type, int threads) {
+    int size = order.size();
+    DistanceMatrix matrix(size - 1);
+    parallelFor(0, size, threads, [&](int i) {
+        for (int j = 0; j < size; j++) {
+            int a = order[i], b = order[j];
+            matrix.set(i, j, a == b ? 0 : tsplibDistance(type, x[a], y[a], x[b], y[b]));
+        }
+    });
+    matrix.setSymmetric(true);
+    return matrix;
+}
+
+// Load a TSPLIB (.tsp) or CVRPLIB (.vrp) file
+// Supports coordinate instances (EUC_2D, CEIL_2D, ATT, GEO, MAN_2D, MAX_2D)
+// and EXPLICIT ones in every row/column matrix layout. The best known value
+// is read from a CVRPLIB "Optimal value: X" / "Best value: X" comment or from
+// a "Cost X" line in a .sol file next to the instance.
+inline Instance loadTsplibInstance(const std::string& path, int threads = 1) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening instance file: " + path);
+    }
+
+    Instance instance;
+    size_t slash = path.find_last_of('/');
+    instance.name = path.substr(slash == std::string::npos ? 0 : slash + 1);
+    instance.name = instance.name.substr(0, instance.name.find_last_of('.'));
+
+    int dimension = 0;
+    std::string weightType = "EUC_2D";
+    std::string weightFormat = "FULL_MATRIX";
+    std::vector<double> x, y;
+    std::vector<int> demands;
+    std::vector<long long> weights;
+    int depot = 0;
+    bool depotSeen = false;
+
+    auto trim = [](std::string text) {
+        size_t begin = text.find_first_not_of(" \t\r");
+        size_t end = text.find_last_not_of(" \t\r");
+        return begin == std::string::npos ? std::string() : text.substr(begin, end - begin + 1);
+    };
+    auto numberAfter = [](const std::string& text, const std::string& label) -> long long {
+        size_t at = text.find(label);
+        if (at == std::string::npos) return -1;
+        std::istringstream rest(text.substr(at + label.size()));
+        double value;
+        return rest >> value ? (long long)std::llround(value) : -1;
+    };
+
+    std::string line;
+    std::string section;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty()) continue;
+        if (line == "EOF") break;
+
+        size_t colon = line.find(':');
+        bool isKeyword = std::isalpha((unsigned char)line[0]);
+        if (isKeyword && colon != std::string::npos) {
+            std::string key = trim(line.substr(0, colon));
+            std::string value = trim(line.substr(colon + 1));
+            section.clear();
+            if (key == "NAME") instance.name = value;
+            else if (key == "DIMENSION") dimension = std::stoi(value);
+            else if (key == "CAPACITY") instance.capacity = std::stoi(value);
+            else if (key == "VEHICLES") instance.vehicles = std::stoi(value);
+            else if (key == "EDGE_WEIGHT_TYPE") weightType = value;
+            else if (key == "EDGE_WEIGHT_FORMAT") weightFormat = value;
+            else if (key == "COMMENT") {
+                long long trucks = numberAfter(value, "trucks:");
+                if (trucks > 0) instance.vehicles = trucks;
+                long long best = numberAfter(value, "Optimal value:");
+                if (best < 0) best = numberAfter(value, "Best value:");
+                if (best >= 0) instance.bestKnown = best;
+            }
+            continue;
+        }
+        if (isKeyword) {
+            section = line;
+            if (section == "NODE_COORD_SECTION") {
+                x.assign(dimension + 1, 0.0);
+                y.assign(dimension + 1, 0.0);
+            } else if (section == "DEMAND_SECTION") {
+                demands.assign(dimension + 1, 0);
+            }
+            continue;
+        }
+
+        std::istringstream fields(line);
+        if (section == "NODE_COORD_SECTION") {
+            int id;
+            double px, py;
+            if (fields >> id >> px >> py && id >= 1 && id <= dimension) {
+                x[id] = px;
+                y[id] = py;
+            }
+        } else if (section == "DEMAND_SECTION") {
+            int id, demand;
+            if (fields >> id >> demand && id >= 1 && id <= dimension) {
+                demands[id] = demand;
+            }
+        } else if (section == "DEPOT_SECTION") {
+            int id;
+            if (fields >> id && id > 0 && !depotSeen) {
+                depot = id - 1;
+                depotSeen = true;
+            }
+        } else if (section == "EDGE_WEIGHT_SECTION") {
+            double value;
+            while (fields >> value) {
+                weights.push_back(std::llround(value));
+            }
+        }
+    }
+    if (dimension < 1) {
+        throw std::runtime_error("Instance has no DIMENSION: " + path);
+    }
+
+    // Depot first, then every other node in file order (ids are 0-based here)
+    std::vector<int> order = {depot};
+    for (int id = 0; id < dimension; id++) {
+        if (id != depot) order.push_back(id);
+    }
+
+    if (weightType == "EXPLICIT") {
+        // Expand the listed triangle or square into a full 0-based table
+        std::vector<long long> full(size_t(dimension) * dimension, 0);
+        size_t next = 0;
+        auto take = [&]() {
+            if (next >= weights.size()) {
+                throw std::runtime_error("EDGE_WEIGHT_SECTION is too short in " + path);
+            }
+            return weights[next++];
+        };
+        auto setBoth = [&](int i, int j, long long value) {
+            full[size_t(i) * dimension + j] = value;
+            full[size_t(j) * dimension + i] = value;
+        };
+        // Column layouts list the transposed triangle of the row layouts
+        std::string format = weightFormat;
+        if (format == "UPPER_COL") format = "LOWER_ROW";
+        else if (format == "LOWER_COL") format = "UPPER_ROW";
+        else if (format == "UPPER_DIAG_COL") format = "LOWER_DIAG_ROW";
+        else if (format == "LOWER_DIAG_COL") format = "UPPER_DIAG_ROW";
+
+        if (format == "FULL_MATRIX") {
+            for (size_t k = 0; k < full.size(); k++) full[k] = take();
+        } else if (format == "UPPER_ROW" || format == "UPPER_DIAG_ROW") {
+            int offset = format == "UPPER_ROW" ? 1 : 0;
+            for (int i = 0; i < dimension; i++) {
+                for (int j = i + offset; j < dimension; j++) setBoth(i, j, take());
+            }
+        } else if (format == "LOWER_ROW" || format == "LOWER_DIAG_ROW") {
+            int offset = format == "LOWER_ROW" ? 0 : 1;
+            for (int i = 0; i < dimension; i++) {
+                for (int j = 0; j < i + offset; j++) setBoth(i, j, take());
+            }
+        } else {
+            throw std::runtime_error("Unsupported EDGE_WEIGHT_FORMAT: " + weightFormat);
+        }
+
+        instance.matrix = DistanceMatrix(dimension - 1);
+        for (int i = 0; i < dimension; i++) {
+            for (int j = 0; j < dimension; j++) {
+                instance.matrix.set(i, j, int(full[size_t(order[i]) * dimension + order[j]]));
+            }
+        }
+        instance.matrix.setSymmetric(instance.matrix.checkSymmetric());
+    } else {
+        if (x.empty()) {
+            throw std::runtime_error("Instance has no NODE_COORD_SECTION: " + path);
+        }
+        // Coordinates were stored 1-based
+        x.erase(x.begin());
+        y.erase(y.begin());
+        instance.matrix = coordinateMatrix(x, y, order, weightType, threads);
+    }
+
+    if (!demands.empty()) {
+        for (int id : order) {
+            instance.demands.push_back(demands[id + 1]);
+        }
+    }
+
+    // CVRPLIB names carry the fleet size as "-kN"
+    size_t fleet = instance.name.rfind("-k");
+    if (instance.vehicles == 0 && fleet != std::string::npos) {
+        instance.vehicles = std::atoi(instance.name.c_str() + fleet + 2);
+    }
+
+    // Solution files next to the instance hold the best known cost
+    std::ifstream solution(path.substr(0, path.find_last_of('.')) + ".sol");
+    while (instance.bestKnown < 0 && std::getline(solution, line)) {
+        if (line.rfind("Cost", 0) == 0) {
+            instance.bestKnown = std::atoll(line.c_str() + 4);
+        }
+    }
+    return instance;
+}
+
+// Seeded synthetic instance: depot and numCustomers points uniform in a
+// 10000 x 10000 square with rounded Euclidean distances
+inline Instance syntheticInstance(int numCustomers, unsigned seed, int threads = 1) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> coordinate(0.0, 10000.0);
+    std::vector<double> x(numCustomers + 1), y(numCustomers + 1);
+    std::vector<int> order(numCustomers + 1);
+    for (int i = 0; i <= numCustomers; i++) {
+        x[i] = coordinate(gen);
+        y[i] = coordinate(gen);
+        order[i] = i;
+    }
+
+    Instance instance;
+    instance.name = "uniform-" + std::to_string(numCustomers) + "-s" + std::to_string(seed);
+    instance.matrix = coordinateMatrix(x, y, order, "EUC_2D", threads);
+    return instance;
+}
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <charconv>
+#include <cstdio>
+#include <stdexcept>
+
+// Minimal JSON value used by the solver daemon's line protocol
+struct JsonValue {
+    enum Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    bool isNull() const { return type == Null; }
+    bool isBool() const { return type == Bool; }
+    bool isNumber() const { return type == Number; }
+    bool isString() const { return type == String; }
+    bool isArray() const { return type == Array; }
+    bool isObject() const { return type == Object; }
+
+    // Member lookup; returns nullptr when absent or not an object
+    const JsonValue* find(const std::string& key) const {
+        if (type != Object) {
+            return nullptr;
+        }
+        for (const auto& [name, value] : object) {
+            if (name == key) {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser {
+public:
+    JsonParser(const char* first, const char* last) : pos(first), end(last) {}
+
+    JsonValue parseDocument() {
+        JsonValue value = parseValue();
+        skipWhitespace();
+        if (pos != end) {
+            fail("trailing characters");
+        }
+        return value;
+    }
+
+private:
+    const char* pos;
+    const char* end;
+
+    [[noreturn]] void fail(const char* what) {
+        throw std::runtime_error(std::string("Invalid JSON: ") + what);
+    }
+
+    void skipWhitespace() {
+        while (pos != end && (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')) {
+            pos++;
+        }
+    }
+
+    void expect(char c) {
+        skipWhitespace();
+        if (pos == end || *pos != c) {
+            fail("unexpected character");
+        }
+        pos++;
+    }
+
+    bool consumeLiteral(const char* literal) {
+        size_t length = std::char_traits<char>::length(literal);
+        if (size_t(end - pos) >= length && std::char_traits<char>::compare(pos, literal, length) == 0) {
+            pos += length;
+            return true;
+        }
+        return false;
+    }
+
+    JsonValue parseValue() {
+        skipWhitespace();
+        if (pos == end) {
+            fail("unexpected end of input");
+        }
+
+        JsonValue value;
+        switch (*pos) {
+        case '{':
+            value.type = JsonValue::Object;
+            pos++;
+            skipWhitespace();
+            if (pos != end && *pos == '}') {
+                pos++;
+                return value;
+            }
+            while (true) {
+                skipWhitespace();
+                std::string key = parseString();
+                expect(':');
+                value.object.emplace_back(std::move(key), parseValue());
+                skipWhitespace();
+                if (pos != end && *pos == ',') {
+                    pos++;
+                    continue;
+                }
+                expect('}');
+                return value;
+            }
+        case '[':
+            value.type = JsonValue::Array;
+            pos++;
+            skipWhitespace();
+            if (pos != end && *pos == ']') {
+                pos++;
+                return value;
+            }
+            while (true) {
+                value.array.push_back(parseValue());
+                skipWhitespace();
+                if (pos != end && *pos == ',') {
+                    pos++;
+                    continue;
+                }
+                expect(']');
+                return value;
+            }
+        case '"':
+            value.type = JsonValue::String;
+            value.string = parseString();
+            return value;
+        default:
+            if (consumeLiteral("true")) {
+                value.type = JsonValue::Bool;
+                value.boolean = true;
+            } else if (consumeLiteral("false")) {
+                value.type = JsonValue::Bool;
+            } else if (consumeLiteral("null")) {
+                value.type = JsonValue::Null;
+            } else {
+                value.type = JsonValue::Number;
+                // Integers dominate matrix payloads; take the cheap path first
+                long long integer;
+                auto result = std::from_chars(pos, end, integer);
+                if (result.ec == std::errc() && (result.ptr == end || (*result.ptr != '.' && *result.ptr != 'e' && *result.ptr != 'E'))) {
+                    value.number = double(integer);
+                } else {
+                    result = std::from_chars(pos, end, value.number);
+                    if (result.ec != std::errc()) {
+                        fail("malformed number");
+                    }
+                }
+                pos = result.ptr;
+            }
+            return value;
+        }
+    }
+
+    std::string parseString() {
+        if (pos == end || *pos != '"') {
+            fail("expected string");
+        }
+        pos++;
+        std::string result;
+        while (pos != end && *pos != '"') {
+            char c = *pos++;
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+            if (pos == end) {
+                break;
+            }
+            char escaped = *pos++;
+            switch (escaped) {
+            case 'n': result += '\n'; break;
+            case 't': result += '\t'; break;
+            case 'r': result += '\r'; break;
+            case 'b': result += '\b'; break;
+            case 'f': result += '\f'; break;
+            case 'u': {
+                if (end - pos < 4) {
+                    fail("truncated escape");
+                }
+                unsigned code = 0;
+                std::from_chars(pos, pos + 4, code, 16);
+                pos += 4;
+                // Basic multilingual plane only, encoded as UTF-8
+                if (code < 0x80) {
+                    result += char(code);
+                } else if (code < 0x800) {
+                    result += char(0xC0 | (code >> 6));
+                    result += char(0x80 | (code & 0x3F));
+                } else {
+                    result += char(0xE0 | (code >> 12));
+                    result += char(0x80 | ((code >> 6) & 0x3F));
+                    result += char(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: result += escaped; break;
+            }
+        }
+        if (pos == end) {
+            fail("unterminated string");
+        }
+        pos++;
+        return result;
+    }
+};
+
+inline JsonValue parseJson(const std::string& text) {
+    return JsonParser(text.data(), text.data() + text.size()).parseDocument();
+}
+
+// Quote and escape a string for JSON output
+inline std::string jsonQuote(const std::string& text) {
+    std::string result = "\"";
+    for (char c : text) {
+        switch (c) {
+        case '"': result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\r': result += "\\r"; break;
+        case '\t': result += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                result += buffer;
+            } else {
+                result += c;
+            }
+        }
+    }
+    return result + "\"";
+}
+
+// Shortest text that reads back as the same double
+inline std::string jsonNumber(double number) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    return std::string(buffer, result.ptr);
+}
+
+// Serialize a value back to compact JSON
+inline std::string toJson(const JsonValue& value) {
+    switch (value.type) {
+    case JsonValue::Null:
+        return "null";
+    case JsonValue::Bool:
+        return value.boolean ? "true" : "false";
+    case JsonValue::Number:
+        return jsonNumber(value.number);
+    case JsonValue::String:
+        return jsonQuote(value.string);
+    case JsonValue::Array: {
+        std::string result = "[";
+        for (size_t i = 0; i < value.array.size(); i++) {
+            if (i > 0) result += ",";
+            result += toJson(value.array[i]);
+        }
+        return result + "]";
+    }
+    case JsonValue::Object: {
+        std::string result = "{";
+        for (size_t i = 0; i < value.object.size(); i++) {
+            if (i > 0) result += ",";
+            result += jsonQuote(value.object[i].first) + ":" + toJson(value.object[i].second);
+        }
+        return result + "}";
+    }
+    }
+    return "null";
+}
+
+// Serialize routes as a JSON array of arrays
+inline std::string routesToJson(const std::vector<std::vector<int>>& routes) {
+    std::string result = "[";
+    for (size_t r = 0; r < routes.size(); r++) {
+        if (r > 0) result += ",";
+        result += "[";
+        for (size_t i = 0; i < routes[r].size(); i++) {
+            if (i > 0) result += ",";
+            result += std::to_string(routes[r][i]);
+        }
+        result += "]";
+    }
+    return result + "]";
+}
+
+#endif
@@ -0,0 +1,529 @@
+#ifndef LOCAL_SEARCH_H
+#define LOCAL_SEARCH_H
+
+#include "common.h"
+#include "neighbors.h"
+#include "telemetry.h"
+#include "control.h"
+#include "constraints.h"
+#include <deque>
+
+// Tuning knobs for localSearchVRP
+struct LocalSearchParams {
+    int neighbors = 20;                   // Candidate partners tried per node
+    int threads = 1;                      // Threads used to build the candidate lists
+    int maxSegment = 3;                   // Longest chain moved by Or-opt (1 = plain relocate)
+    const NeighborLists* index = nullptr; // Prebuilt candidate lists to reuse
+    Telemetry* telemetry = nullptr;       // Search phase time and move counters
+    const SolveControl* control = nullptr; // Stops the search early; the result is streamed
+    const Constraints* constraints = nullptr; // Capacity/time windows the moves must respect
+    const std::vector<int>* focus = nullptr;  // Warm start: only these nodes start queued (see below)
+};
+
+// Work counters filled in by localSearchVRP when requested
+struct LocalSearchStats {
+    long long evaluations = 0;  // Nodes popped from the work queue
+    long long moves = 0;        // Improving moves applied
+};
+
+// First-improvement local search over a set of routes
+// Every node u is paired only with its k nearest neighbours v, and each move
+// creates an edge between u and v:
+//  - 2-opt: reverse a stretch of u's route so u and v become adjacent
+//  - 2-opt*: exchange route tails so that u -> v (or v -> u) joins two routes
+//  - Or-opt: move a chain of up to maxSegment nodes starting or ending at u
+//    next to v, in any route (a chain of one is a relocate)
+//  - swap*: exchange u and v between their routes, each going to its best
+//    position among the other node's neighbours rather than the freed slot
+// Don't-look bits keep a queue of nodes whose surroundings changed; a node
+// that yields no improving move is dropped until a later move touches it, so
+// a pass costs O(n k) evaluations plus the O(route length) cost of applying
+// each accepted move.
+// With constraints, every route keeps prefix and suffix segment summaries
+// (see constraints.h), so the routes a move would produce are priced by
+// joining a few known pieces: 2-opt*, inter-route Or-opt and every capacity
+// check are O(1). Only the time windows of a stretch that an intra-route move
+// reverses or shifts are walked. A move must not add violation (excess load
+// plus time warp), and one that removes some is taken even if it costs
+// distance, so infeasible input is repaired on the way.
+// With a focus (a warm start after a few stops changed) only the focus nodes
+// start queued, so the search stays around them unless moves spread it, and
+// nodes the routes do not visit are left out. Without a prebuilt index the
+// candidate lists are then computed the first time a node is looked at, so
+// the search costs O(n) per node it reaches instead of O(n^2) up front.
+template <typename Matrix>
+class LocalSearch {
+public:
+    LocalSearch(const Matrix& matrix, const std::vector<std::vector<int>>& initial,
+                const LocalSearchParams& params)
+        : matrix(matrix), params(params), n(matrix.customers()) {
+        if (params.constraints != nullptr && params.constraints->active()) {
+            constraints = params.constraints;
+        }
+        // A sparse matrix's own lists are cheap to copy and it has no rows to sort
+        lazy = !Matrix::SPARSE && params.focus != nullptr && params.index == nullptr;
+        if (params.index == nullptr && !lazy) {
+            localIndex = NeighborLists(matrix, params.neighbors, params.threads);
+        }
+        index = params.index != nullptr ? params.index : &localIndex;
+
+        // Routes are stored with explicit depot endpoints
+        routeOf.assign(n + 1, -1);
+        posOf.assign(n + 1, 0);
+        for (const auto& route : initial) {
+            std::vector<int> nodes = {0};
+            for (int node : route) {
+                if (node != 0) nodes.push_back(node);
+            }
+            nodes.push_back(0);
+            routes.push_back(std::move(nodes));
+            forward.emplace_back();
+            backward.emplace_back();
+            prefix.emplace_back();
+            suffix.emplace_back();
+            violation.push_back(0);
+            refresh(routes.size() - 1);
+        }
+        int visited = 0;
+        for (int node = 1; node <= n; node++) {
+            if (routeOf[node] >= 0) {
+                visited++;
+            } else if (params.focus == nullptr) {
+                throw std::runtime_error("Local search input does not visit node " + std::to_string(node));
+            }
+        }
+        width = std::min(params.neighbors, lazy ? visited - 1 : index->k());
+        if (lazy) {
+            lazyIndex.resize(n + 1);
+        }
+
+        if (params.focus == nullptr) {
+            queued.assign(n + 1, 1);
+            for (int node = 1; node <= n; node++) {
+                queue.push_back(node);
+            }
+        } else {
+            queued.assign(n + 1, 0);
+            for (int node : *params.focus) {
+                if (node > 0 && node <= n && routeOf[node] >= 0) activate(node);
+            }
+        }
+    }
+
+    // Run until no queued node has an improving move, or until the
+    // control asks to stop (polled every 256 nodes)
+    void run() {
+        while (!queue.empty()) {
+            if ((stats.evaluations & 255) == 0 && stopRequested(params.control)) {
+                break;
+            }
+            int u = queue.front();
+            queue.pop_front();
+            queued[u] = 0;
+            stats.evaluations++;
+            if (improve(u)) {
+                stats.moves++;
+            }
+        }
+    }
+
+    const LocalSearchStats& counters() const { return stats; }
+
+    std::vector<std::vector<int>> result() const { return routes; }
+
+private:
+    const Matrix& matrix;
+    const LocalSearchParams& params;
+    int n;
+    NeighborLists localIndex;
+    const NeighborLists* index;
+    bool lazy = false;                                // Candidate lists built on first use
+    mutable std::vector<std::vector<int>> lazyIndex;
+    int width;
+    std::vector<std::vector<int>> routes;
+    std::vector<std::vector<int>> forward;   // forward[r][i]: cost of routes[r][0..i] walked forwards
+    std::vector<std::vector<int>> backward;  // backward[r][i]: the same prefix walked backwards
+    const Constraints* constraints = nullptr;         // nullptr when unconstrained
+    std::vector<std::vector<RouteSegment>> prefix;    // prefix[r][i]: summary of routes[r][0..i]
+    std::vector<std::vector<RouteSegment>> suffix;    // suffix[r][i]: summary of routes[r][i..end]
+    std::vector<int> violation;                       // Violation of each route
+    std::vector<int> routeOf;
+    std::vector<int> posOf;
+    std::deque<int> queue;
+    std::vector<char> queued;
+    LocalSearchStats stats;
+
+    int d(int from, int to) const { return matrix(from, to); }
+
+    int prevOf(int node) const { return routes[routeOf[node]][posOf[node] - 1]; }
+
+    int nextOf(int node) const { return routes[routeOf[node]][posOf[node] + 1]; }
+
+    // The width nearest visited customers of node
+    const int* candidatesOf(int node) const {
+        if (!lazy) {
+            return index->of(node);
+        }
+        auto& list = lazyIndex[node];
+        if constexpr (!Matrix::SPARSE) {
+            if (list.empty() && width > 0) {
+                std::vector<std::pair<int, int>> others;
+                const auto* row = matrix.row(node);
+                for (int j = 1; j <= n; j++) {
+                    if (j != node && routeOf[j] >= 0) others.push_back({row[j], j});
+                }
+                std::partial_sort(others.begin(), others.begin() + width, others.end());
+                for (int c = 0; c < width; c++) {
+                    list.push_back(others[c].second);
+                }
+            }
+        }
+        return list.data();
+    }
+
+    // Clear the don't-look bit of a customer
+    void activate(int node) {
+        if (node != 0 && !queued[node]) {
+            queued[node] = 1;
+            queue.push_back(node);
+        }
+    }
+
+    // Re-index a route after it changed
+    void refresh(int r) {
+        const auto& nodes = routes[r];
+        for (size_t i = 1; i + 1 < nodes.size(); i++) {
+            routeOf[nodes[i]] = r;
+            posOf[nodes[i]] = i;
+        }
+        if (!matrix.symmetric()) {
+            forward[r].assign(nodes.size(), 0);
+            backward[r].assign(nodes.size(), 0);
+            for (size_t i = 1; i < nodes.size(); i++) {
+                forward[r][i] = forward[r][i - 1] + d(nodes[i - 1], nodes[i]);
+                backward[r][i] = backward[r][i - 1] + d(nodes[i], nodes[i - 1]);
+            }
+        }
+        if (constraints != nullptr) {
+            size_t size = nodes.size();
+            prefix[r].resize(size);
+            suffix[r].resize(size);
+            prefix[r][0] = constraints->node(nodes[0]);
+            suffix[r][size - 1] = constraints->node(nodes[size - 1]);
+            for (size_t i = 1; i < size; i++) {
+                prefix[r][i] = join(prefix[r][i - 1], constraints->node(nodes[i]));
+                suffix[r][size - 1 - i] = join(constraints->node(nodes[size - 1 - i]), suffix[r][size - i]);
+            }
+            violation[r] = constraints->violation(prefix[r][size - 1]);
+        }
+    }
+
+    RouteSegment join(const RouteSegment& a, const RouteSegment& b) const {
+        return constraints->join(a, b, matrix);
+    }
+
+    int violationOf(const RouteSegment& a, const RouteSegment& b) const {
+        return constraints->violation(join(a, b));
+    }
+
+    // Summary of routes[r][s..e], reversed if asked. Pieces touching a route
+    // end and, without time windows, any piece are O(1); other time window
+    // pieces are walked.
+    RouteSegment stretch(int r, int s, int e, bool reversed = false) const {
+        if (s > e) {
+            return RouteSegment();
+        }
+        const auto& nodes = routes[r];
+        if (!reversed && s == 0) return prefix[r][e];
+        if (!reversed && e + 1 == int(nodes.size())) return suffix[r][s];
+        if (!constraints->hasTimeWindows()) {
+            RouteSegment segment = constraints->node(reversed ? nodes[e] : nodes[s]);
+            segment.last = reversed ? nodes[s] : nodes[e];
+            segment.load = prefix[r][e].load - prefix[r][s - 1].load;
+            return segment;
+        }
+        RouteSegment segment;
+        for (int i = s; i <= e; i++) {
+            segment = join(segment, constraints->node(nodes[reversed ? s + e - i : i]));
+        }
+        return segment;
+    }
+
+    // Whether a move that changes distance by delta should be taken, given
+    // the violation of the routes it touches before and (lazily) after
+    template <typename After>
+    bool accepts(int delta, int before, After after) const {
+        if (constraints == nullptr) {
+            return delta < 0;
+        }
+        if (delta >= 0 && before == 0) {
+            return false;
+        }
+        int violationAfter = after();
+        return violationAfter < before || (violationAfter == before && delta < 0);
+    }
+
+    // Cost change of reversing routes[r][s..e]
+    int reversalDelta(int r, int s, int e) const {
+        const auto& nodes = routes[r];
+        int delta = d(nodes[s - 1], nodes[e]) + d(nodes[s], nodes[e + 1])
+                  - d(nodes[s - 1], nodes[s]) - d(nodes[e], nodes[e + 1]);
+        if (!matrix.symmetric()) {
+            delta += (backward[r][e] - backward[r][s]) - (forward[r][e] - forward[r][s]);
+        }
+        return delta;
+    }
+
+    // Insert nodes after `after` in route r (after == 0 means the route start)
+    void insertAfter(int r, int after, const std::vector<int>& nodes) {
+        auto& route = routes[r];
+        size_t at = 1;
+        if (after != 0) {
+            at = std::find(route.begin() + 1, route.end() - 1, after) - route.begin() + 1;
+        }
+        route.insert(route.begin() + at, nodes.begin(), nodes.end());
+    }
+
+    bool improve(int u) {
+        const int* candidates = candidatesOf(u);
+        for (int c = 0; c < width; c++) {
+            int v = candidates[c];
+            if (routeOf[v] < 0) continue;
+            if (routeOf[u] == routeOf[v]) {
+                if (tryTwoOpt(u, v)) return true;
+            } else {
+                if (tryTwoOptStar(u, v)) return true;
+            }
+            if (tryOrOpt(u, v)) return true;
+            if (routeOf[u] != routeOf[v] && trySwapStar(u, v)) return true;
+        }
+        return false;
+    }
+
+    // Reverse the stretch between u and v so that they become adjacent
+    bool tryTwoOpt(int u, int v) {
+        int r = routeOf[u];
+        int lo = std::min(posOf[u], posOf[v]);
+        int hi = std::max(posOf[u], posOf[v]);
+        const auto& nodes = routes[r];
+        // Either the stretch after lo or the stretch before hi
+        int spans[2][2] = {{lo + 1, hi}, {lo, hi - 1}};
+        for (auto& span : spans) {
+            int s = span[0], e = span[1];
+            if (s >= e) continue;
+            auto after = [&] {
+                return violationOf(join(prefix[r][s - 1], stretch(r, s, e, true)), suffix[r][e + 1]);
+            };
+            if (accepts(reversalDelta(r, s, e), constraints ? violation[r] : 0, after)) {
+                int touched[4] = {nodes[s - 1], nodes[s], nodes[e], nodes[e + 1]};
+                std::reverse(routes[r].begin() + s, routes[r].begin() + e + 1);
+                refresh(r);
+                for (int node : touched) activate(node);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Join the head of one route to the tail of the other at edge u -> v or v -> u
+    bool tryTwoOptStar(int u, int v) {
+        for (int pass = 0; pass < 2; pass++) {
+            // The new edge is a -> b; a keeps its head, b keeps its tail
+            int a = pass == 0 ? u : v;
+            int b = pass == 0 ? v : u;
+            int na = nextOf(a), pb = prevOf(b);
+            int delta = d(a, b) + d(pb, na) - d(a, na) - d(pb, b);
+            int ra = routeOf[a], rb = routeOf[b];
+            auto after = [&] {
+                return violationOf(prefix[ra][posOf[a]], suffix[rb][posOf[b]]) +
+                       violationOf(prefix[rb][posOf[b] - 1], suffix[ra][posOf[a] + 1]);
+            };
+            if (accepts(delta, constraints ? violation[ra] + violation[rb] : 0, after)) {
+                std::vector<int> first(routes[ra].begin(), routes[ra].begin() + posOf[a] + 1);
+                first.insert(first.end(), routes[rb].begin() + posOf[b], routes[rb].end());
+                std::vector<int> second(routes[rb].begin(), routes[rb].begin() + posOf[b]);
+                second.insert(second.end(), routes[ra].begin() + posOf[a] + 1, routes[ra].end());
+                routes[ra].swap(first);
+                routes[rb].swap(second);
+                refresh(ra);
+                refresh(rb);
+                for (int node : {a, b, na, pb}) activate(node);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Move a chain that starts at u to just after v, or one that ends at u
+    // to just before v
+    bool tryOrOpt(int u, int v) {
+        int ru = routeOf[u], rv = routeOf[v];
+        const auto& route = routes[ru];
+        int last = route.size() - 2;
+        for (int length = 1; length <= params.maxSegment; length++) {
+            for (int side = 0; side < 2; side++) {
+                int s = side == 0 ? posOf[u] : posOf[u] - length + 1;
+                int e = s + length - 1;
+                if (s < 1 || e > last) continue;
+                if (ru == rv && posOf[v] >= s && posOf[v] <= e) continue;
+                int first = route[s], tail = route[e];
+                int p = route[s - 1], q = route[e + 1];
+                int removeGain = d(p, first) + d(tail, q) - d(p, q);
+
+                // Insertion edge x -> y, read from v's route with the chain removed
+                int x, y;
+                if (side == 0) {
+                    x = v;
+                    y = nextOf(v) == first ? q : nextOf(v);
+                    if (ru == rv && x == p) continue;
+                } else {
+                    y = v;
+                    x = prevOf(v) == tail ? p : prevOf(v);
+                    if (ru == rv && y == q) continue;
+                }
+                int delta = d(x, first) + d(tail, y) - d(x, y) - removeGain;
+                // The chain goes in behind position px of v's route
+                int px = side == 0 ? posOf[v] : posOf[v] - 1;
+                auto after = [&] {
+                    RouteSegment chain = stretch(ru, s, e);
+                    if (ru != rv) {
+                        return violationOf(prefix[ru][s - 1], suffix[ru][e + 1]) +
+                               violationOf(join(prefix[rv][px], chain), suffix[rv][px + 1]);
+                    }
+                    if (px < s) {
+                        return violationOf(join(join(prefix[ru][px], chain), stretch(ru, px + 1, s - 1)),
+                                           suffix[ru][e + 1]);
+                    }
+                    return violationOf(join(join(prefix[ru][s - 1], stretch(ru, e + 1, px)), chain), suffix[ru][px + 1]);
+                };
+                int before = constraints == nullptr ? 0 : ru == rv ? violation[ru] : violation[ru] + violation[rv];
+                if (accepts(delta, before, after)) {
+                    std::vector<int> chain(route.begin() + s, route.begin() + e + 1);
+                    routes[ru].erase(routes[ru].begin() + s, routes[ru].begin() + e + 1);
+                    insertAfter(rv, x, chain);
+                    refresh(ru);
+                    if (rv != ru) refresh(rv);
+                    for (int node : {p, q, x, y, first, tail}) activate(node);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Cheapest place for `node` in the route of `other` once `other` has left
+    // it: the freed slot or either side of any of node's neighbours there.
+    // Returns the cost and sets `after` to the node to insert behind.
+    int bestInsertion(int node, int other, int& after) const {
+        int r = routeOf[other];
+        int po = prevOf(other), no = nextOf(other);
+        int best = d(po, node) + d(node, no) - d(po, no);
+        after = po;
+
+        const int* candidates = candidatesOf(node);
+        for (int c = 0; c < width; c++) {
+            int w = candidates[c];
+            if (w == other || routeOf[w] != r) continue;
+            int next = nextOf(w) == other ? no : nextOf(w);
+            int prev = prevOf(w) == other ? po : prevOf(w);
+            int cost = d(w, node) + d(node, next) - d(w, next);
+            if (cost < best) {
+                best = cost;
+                after = w;
+            }
+            cost = d(prev, node) + d(node, w) - d(prev, w);
+            if (cost < best) {
+                best = cost;
+                after = prev;
+            }
+        }
+        return best;
+    }
+
+    // Summary of route r once `out` has left it and `in` sits behind `after`
+    RouteSegment exchanged(int r, int out, int in, int after) const {
+        int o = posOf[out];
+        int a = after == 0 ? 0 : posOf[after];
+        RouteSegment node = constraints->node(in);
+        if (a < o) {
+            return join(join(join(prefix[r][a], node), stretch(r, a + 1, o - 1)), suffix[r][o + 1]);
+        }
+        return join(join(join(prefix[r][o - 1], stretch(r, o + 1, a)), node), suffix[r][a + 1]);
+    }
+
+    // Exchange u and v between their routes, each to its best position
+    // (constraints are checked for those cheapest positions only)
+    bool trySwapStar(int u, int v) {
+        int pu = prevOf(u), nu = nextOf(u), pv = prevOf(v), nv = nextOf(v);
+        int gain = d(pu, u) + d(u, nu) - d(pu, nu) + d(pv, v) + d(v, nv) - d(pv, nv);
+        int afterU, afterV;
+        int delta = bestInsertion(u, v, afterU) + bestInsertion(v, u, afterV) - gain;
+        int ru = routeOf[u], rv = routeOf[v];
+        auto after = [&] {
+            return constraints->violation(exchanged(ru, u, v, afterV)) +
+                   constraints->violation(exchanged(rv, v, u, afterU));
+        };
+        if (!accepts(delta, constraints ? violation[ru] + violation[rv] : 0, after)) {
+            return false;
+        }
+
+        routes[ru].erase(routes[ru].begin() + posOf[u]);
+        routes[rv].erase(routes[rv].begin() + posOf[v]);
+        insertAfter(rv, afterU, {u});
+        insertAfter(ru, afterV, {v});
+        refresh(ru);
+        refresh(rv);
+        for (int node : {u, v, pu, nu, pv, nv, prevOf(u), nextOf(u), prevOf(v), nextOf(v)}) activate(node);
+        return true;
+    }
+};
+
+// Improve any solver's routes with the local search stage
+template <typename Matrix>
+std::vector<std::vector<int>> localSearchVRP(const Matrix& matrix,
+                                             const std::vector<std::vector<int>>& routes,
+                                             const LocalSearchParams& params,
+                                             LocalSearchStats* stats = nullptr) {
+    return timePhase(params.telemetry, "search", [&] {
+        LocalSearch search(matrix, routes, params);
+        search.run();
+        if (stats != nullptr) {
+            *stats = search.counters();
+        }
+        if (params.telemetry != nullptr) {
+            params.telemetry->setCounter("ls_evaluations", search.counters().evaluations);
+            params.telemetry->setCounter("ls_moves", search.counters().moves);
+        }
+        auto improved = search.result();
+        reportRoutes(params.control, matrix, improved);
+        return improved;
+    });
+}
+
+template <typename Matrix>
+std::vector<std::vector<int>> localSearchVRP(const Matrix& matrix, const std::vector<std::vector<int>>& routes) {
+    return localSearchVRP(matrix, routes, LocalSearchParams());
+}
+
+// Chain the stage after a solver when the command line asks for it:
+// --local-search [--ls-neighbors K] [--ls-segment L]
+template <typename Matrix>
+void applyLocalSearchOption(const CommandLine& commandLine, const Matrix& matrix,
+                            std::vector<std::vector<int>>& routes,
+                            const NeighborLists* index = nullptr, Telemetry* telemetry = nullptr,
+                            const SolveControl* control = nullptr, const Constraints* constraints = nullptr) {
+    if (!commandLine.has("local-search")) {
+        return;
+    }
+    LocalSearchParams params;
+    params.neighbors = commandLine.getNumber("ls-neighbors", params.neighbors);
+    params.maxSegment = commandLine.getNumber("ls-segment", params.maxSegment);
+    params.threads = commandLine.getNumber("threads", params.threads);
+    params.index = index;
+    params.telemetry = telemetry;
+    params.control = control;
+    params.constraints = constraints;
+    routes = localSearchVRP(matrix, routes, params);
+}
+
+#endif
@@ -1,89 +1,51 @@
-#include "common.h"
+#include "nearest_neighbor.h"
+#include "local_search.h"
 
-// Nearest Neighbor heuristic for VRP
-std::vector<std::vector<int>> nearestNeighborVRP(const std::vector<std::vector<int>>& matrix, int numVehicles) {
-    int n = matrix.size();
-    std::vector<bool> visited(n + 1, false);
-    std::vector<std::vector<int>> routes(numVehicles);
-    
-    // Start all routes from depot (0)
-    for (int v = 0; v < numVehicles; v++) {
-        routes[v].push_back(0);
-    }
-    
-    // Assign nodes to vehicles round-robin style using nearest neighbor
-    int currentVehicle = 0;
-    int nodesRemaining = n;
-    
-    while (nodesRemaining > 0) {
-        // Get last node in current vehicle's route
-        int lastNode = routes[currentVehicle].back();
-        int nearestNode = -1;
-        int minDistance = std::numeric_limits<int>::max();
-        
-        // Find nearest unvisited node
-        for (int j = 1; j <= n; j++) {
-            if (!visited[j]) {
-                int distance;
-                if (lastNode == 0) {
-                    // Distance from depot to node j
-                    distance = matrix[j-1][0];
-                } else {
-                    // Distance from lastNode to node j
-                    distance = matrix[lastNode-1][j];
-                }
-                
-                if (distance < minDistance) {
-                    minDistance = distance;
-                    nearestNode = j;
-                }
-            }
-        }
-        
-        // Add nearest node to route
-        if (nearestNode != -1) {
-            routes[currentVehicle].push_back(nearestNode);
-            visited[nearestNode] = true;
-            nodesRemaining--;
-        }
-        
-        // Move to next vehicle
-        currentVehicle = (currentVehicle + 1) % numVehicles;
-    }
-    
-    // Add depot at the end of each route
-    for (auto& route : routes) {
-        route.push_back(0);
-    }
-    
-    return routes;
-}
+// Usage: nearest_neighbor [numVehicles] [matrixFile] [--neighbors K] [--threads T]
+//          [--local-search [--ls-neighbors K] [--ls-segment L]]
+//          [--telemetry[=FILE]] [--time-limit SECONDS] [--stream]
+//          [--constraints FILE] [--distance-type auto|int32|uint16]
+//          [--sparse K [--metric haversine|equirectangular]]
+// With --sparse K, matrixFile is a coordinates file ("lat lon" lines, depot
+// first) and only each stop's K nearest distances are stored (sparse_matrix.h).
+// The candidate lists are built once and shared with the local search stage
+int main(int argc, char** argv) try {
+    CommandLine commandLine = parseCommandLine(argc, argv);
+    SolveControl control;
+    configureControl(commandLine, control);
+    Telemetry telemetry;
+    Telemetry* probe = telemetryFromCommandLine(commandLine, telemetry);
+    auto solve = [&](const auto& matrix) {
+        int numVehicles = commandLine.numVehicles;
+        Constraints constraints;
+        const Constraints* limits = constraintsFromCommandLine(commandLine, matrix, constraints);
 
-int main(int argc, char** argv) {
-    auto matrix = readDistanceMatrix();
-    
-    // Default to 2 vehicles
-    int numVehicles = 2;
-    
-    // Use command line argument if provided
-    if (argc > 1) {
-        numVehicles = std::atoi(argv[1]);
-    }
-    
-    // For brute force, check if problem size is manageable
-    if (matrix.size() > 10 && std::string(argv[0]).find("brute_force") != std::string::npos) {
-        std::cerr << "Warning: Brute force is impractical for " << matrix.size() 
-                  << " nodes. Using " << numVehicles << " vehicles and limiting to first 8 nodes." << std::endl;
-        
-        // Truncate the matrix to avoid excessive computation
-        if (matrix.size() > 8) {
-            matrix.resize(8);
-        }
+        NearestNeighborParams params;
+        params.neighbors = commandLine.getNumber("neighbors", params.neighbors);
+        params.threads = commandLine.getNumber("threads", params.threads);
+        params.constraints = limits;
+        NeighborLists index = timePhase(probe, "construct", [&] {
+            return NeighborLists(matrix, params.neighbors, params.threads);
+        });
+        params.index = &index;
+
+        auto routes = timePhase(probe, "construct", [&] { return nearestNeighborVRP(matrix, numVehicles, params); });
+        reportRoutes(&control, matrix, routes);
+        applyLocalSearchOption(commandLine, matrix, routes, &index, probe, &control, limits);
+        warnViolations(limits, routes, matrix);
+        timePhase(probe, "write", [&] { writeRoutes(routes); });
+        writeTelemetry(commandLine, probe, "nearest_neighbor", matrix);
+
+        return 0;
+    };
+    if (commandLine.has("sparse")) {
+        return solve(timePhase(probe, "parse", [&] { return sparseMatrixFromCommandLine(commandLine); }));
     }
-    
-    // Run the appropriate algorithm (already defined in each file)
-    auto routes = nearestNeighborVRP(matrix, numVehicles);
-    writeRoutes(routes);
-    
-    return 0;
-}
\ No newline at end of file
+    auto stored = timePhase(probe, "parse", [&] {
+        return loadDistanceMatrix(commandLine.matrixFile, commandLine.get("distance-type", "auto"));
+    });
+    return stored.visit(solve);
+} catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+}
@@ -0,0 +1,225 @@
+#ifndef NEAREST_NEIGHBOR_H
+#define NEAREST_NEIGHBOR_H
+
+#include "common.h"
+#include "neighbors.h"
+#include "constraints.h"
+#include "sparse_matrix.h"
+
+// Tuning knobs for nearestNeighborVRP
+struct NearestNeighborParams {
+    int neighbors = 32;                // Candidates per node when the index is built here
+    int threads = 1;                   // Threads used to build the index
+    const NeighborLists* index = nullptr; // Prebuilt index to reuse across solves
+    const Constraints* constraints = nullptr; // Capacity/time windows for every appended stop
+};
+
+// Index of the smallest row[j] over j in [1, n] with blocked[j] == 0, or -1.
+// blocked[j] is INT_MAX for visited nodes and INT_MIN otherwise, so
+// max(row[j], blocked[j]) masks without a branch and the min pass vectorizes.
+// Raw compact cells order the same way as the distances they stand for.
+template <typename Cell>
+int maskedArgMin(const Cell* row, const int* blocked, int n) {
+    int minDistance = std::numeric_limits<int>::max();
+    for (int j = 1; j <= n; j++) {
+        minDistance = std::min(minDistance, std::max(int(row[j]), blocked[j]));
+    }
+    for (int j = 1; j <= n; j++) {
+        if (blocked[j] != std::numeric_limits<int>::max() && row[j] == minDistance) {
+            return j;
+        }
+    }
+    return -1;
+}
+
+// Constrained nearest neighbour: each vehicle in turn appends its nearest
+// unvisited stop that it can still serve and get back to the depot in time,
+// checked in O(1) by joining the route's segment summary with the stop and
+// the depot. A vehicle that can take no stop is closed; once every vehicle
+// is closed, extra routes are opened for what is left. A stop that no empty
+// route can serve is given a route of its own.
+template <typename Matrix>
+std::vector<std::vector<int>> constrainedNearestNeighbor(const Matrix& matrix, int numVehicles,
+                                                         const NeighborLists& index,
+                                                         const Constraints& constraints) {
+    int n = matrix.customers();
+    std::vector<char> visited(n + 1, 0);
+    std::vector<int> cursor(n + 1, 0);
+    std::vector<std::vector<int>> routes(numVehicles, std::vector<int>{0});
+    std::vector<RouteSegment> segments(numVehicles, constraints.node(0));
+    std::vector<char> open(numVehicles, 1);
+    RouteSegment depot = constraints.node(0);
+    SpatialIndex unvisited;
+    if constexpr (Matrix::SPARSE) {
+        unvisited = matrix.index();
+    }
+
+    auto canAppend = [&](int v, int node) {
+        RouteSegment extended = constraints.join(segments[v], constraints.node(node), matrix);
+        return constraints.violation(constraints.join(extended, depot, matrix)) == 0;
+    };
+
+    int openVehicles = numVehicles;
+    int currentVehicle = 0;
+    int nodesRemaining = n;
+    while (nodesRemaining > 0) {
+        if (openVehicles == 0) {
+            routes.push_back({0});
+            segments.push_back(depot);
+            open.push_back(1);
+            openVehicles++;
+            currentVehicle = routes.size() - 1;
+        }
+        if (!open[currentVehicle]) {
+            currentVehicle = (currentVehicle + 1) % routes.size();
+            continue;
+        }
+
+        // Nearest feasible unvisited node: candidate list first, else full scan
+        int lastNode = routes[currentVehicle].back();
+        const int* candidates = index.of(lastNode);
+        int& next = cursor[lastNode];
+        while (next < index.k() && visited[candidates[next]]) {
+            next++;
+        }
+        int nearestNode = -1;
+        for (int c = next; c < index.k() && nearestNode < 0; c++) {
+            if (!visited[candidates[c]] && canAppend(currentVehicle, candidates[c])) {
+                nearestNode = candidates[c];
+            }
+        }
+        if (nearestNode < 0) {
+            if constexpr (Matrix::SPARSE) {
+                nearestNode = matrix.nearestIn(unvisited, lastNode, [&](int j) { return canAppend(currentVehicle, j); });
+            } else {
+                const auto* row = matrix.row(lastNode);
+                for (int j = 1; j <= n; j++) {
+                    if (!visited[j] && (nearestNode < 0 || row[j] < row[nearestNode]) &&
+                        canAppend(currentVehicle, j)) {
+                        nearestNode = j;
+                    }
+                }
+            }
+        }
+
+        bool forced = false;
+        if (nearestNode < 0 && routes[currentVehicle].size() == 1) {
+            if constexpr (Matrix::SPARSE) {
+                nearestNode = matrix.nearestIn(unvisited, 0);
+            } else {
+                const auto* row = matrix.row(0);
+                for (int j = 1; j <= n; j++) {
+                    if (!visited[j] && (nearestNode < 0 || row[j] < row[nearestNode])) {
+                        nearestNode = j;
+                    }
+                }
+            }
+            forced = true;
+        }
+
+        if (nearestNode >= 0) {
+            routes[currentVehicle].push_back(nearestNode);
+            segments[currentVehicle] = constraints.join(segments[currentVehicle], constraints.node(nearestNode), matrix);
+            visited[nearestNode] = 1;
+            if constexpr (Matrix::SPARSE) {
+                unvisited.remove(nearestNode);
+            }
+            nodesRemaining--;
+        }
+        if (nearestNode < 0 || forced) {
+            open[currentVehicle] = 0;
+            openVehicles--;
+        }
+        currentVehicle = (currentVehicle + 1) % routes.size();
+    }
+
+    for (auto& route : routes) {
+        route.push_back(0);
+    }
+    return routes;
+}
+
+// Nearest Neighbor heuristic for VRP
+// Each node's sorted candidate list is consumed through a cursor that skips
+// visited entries and never moves back, so finding the nearest unvisited
+// node costs amortised O(1); only when a node's list runs out does it fall
+// back to a masked scan of its matrix row. Lists are ordered by (distance,
+// index), so the routes match a plain full scan exactly. A sparse matrix has
+// no rows; the fallback asks its spatial index for the nearest unvisited node.
+template <typename Matrix>
+std::vector<std::vector<int>> nearestNeighborVRP(const Matrix& matrix, int numVehicles,
+                                                 const NearestNeighborParams& params) {
+    int n = matrix.customers();
+    NeighborLists localIndex;
+    if (params.index == nullptr) {
+        localIndex = NeighborLists(matrix, params.neighbors, params.threads);
+    }
+    const NeighborLists& index = params.index != nullptr ? *params.index : localIndex;
+    if (params.constraints != nullptr && params.constraints->active()) {
+        return constrainedNearestNeighbor(matrix, numVehicles, index, *params.constraints);
+    }
+
+    std::vector<int> blocked(n + 1, std::numeric_limits<int>::min());
+    std::vector<int> cursor(n + 1, 0);
+    std::vector<std::vector<int>> routes(numVehicles);
+    SpatialIndex unvisited;
+    if constexpr (Matrix::SPARSE) {
+        unvisited = matrix.index();
+    }
+    
+    // Start all routes from depot (0)
+    for (int v = 0; v < numVehicles; v++) {
+        routes[v].push_back(0);
+    }
+    
+    // Assign nodes to vehicles round-robin style using nearest neighbor
+    int currentVehicle = 0;
+    int nodesRemaining = n;
+    
+    while (nodesRemaining > 0) {
+        // Get last node in current vehicle's route
+        int lastNode = routes[currentVehicle].back();
+        int nearestNode = -1;
+        
+        // Find nearest unvisited node: first live candidate, else full scan
+        const int* candidates = index.of(lastNode);
+        int& next = cursor[lastNode];
+        while (next < index.k() && blocked[candidates[next]] != std::numeric_limits<int>::min()) {
+            next++;
+        }
+        if (next < index.k()) {
+            nearestNode = candidates[next];
+        } else if constexpr (Matrix::SPARSE) {
+            nearestNode = matrix.nearestIn(unvisited, lastNode);
+        } else {
+            nearestNode = maskedArgMin(matrix.row(lastNode), blocked.data(), n);
+        }
+        
+        // Add nearest node to route
+        if (nearestNode != -1) {
+            routes[currentVehicle].push_back(nearestNode);
+            blocked[nearestNode] = std::numeric_limits<int>::max();
+            if constexpr (Matrix::SPARSE) {
+                unvisited.remove(nearestNode);
+            }
+            nodesRemaining--;
+        }
+        
+        // Move to next vehicle
+        currentVehicle = (currentVehicle + 1) % numVehicles;
+    }
+    
+    // Add depot at the end of each route
+    for (auto& route : routes) {
+        route.push_back(0);
+    }
+    
+    return routes;
+}
+
+template <typename Matrix>
+std::vector<std::vector<int>> nearestNeighborVRP(const Matrix& matrix, int numVehicles) {
+    return nearestNeighborVRP(matrix, numVehicles, NearestNeighborParams());
+}
+
+#endif
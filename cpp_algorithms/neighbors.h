@@ -0,0 +1,55 @@
+#ifndef NEIGHBORS_H
+#define NEIGHBORS_H
+
+#include "common.h"
+#include "parallel.h"
+
+// For every node (depot included), its k closest delivery points by outgoing
+// distance d(node, j), nearest first. Stored as one flat node-major array, so
+// a solver walks a node's candidates with a single contiguous read.
+// A sparse matrix already holds these lists, so they are copied from it.
+class NeighborLists {
+public:
+    NeighborLists() = default;
+
+    template <typename Matrix>
+    NeighborLists(const Matrix& matrix, int k, int threads = 1)
+        : width(std::max(0, std::min(k, matrix.customers() - 1))), numNodes(matrix.size()) {
+        if constexpr (Matrix::SPARSE) {
+            width = std::min(width, matrix.k());
+        }
+        data.resize(size_t(numNodes) * width);
+
+        if constexpr (Matrix::SPARSE) {
+            for (int node = 0; node < numNodes; node++) {
+                std::copy(matrix.nearest(node), matrix.nearest(node) + width, data.begin() + size_t(node) * width);
+            }
+            return;
+        }
+        parallelFor(0, numNodes, threads, [&](int node) {
+            std::vector<int> candidates;
+            candidates.reserve(matrix.customers());
+            for (int j = 1; j <= matrix.customers(); j++) {
+                if (j != node) candidates.push_back(j);
+            }
+            auto closer = [&](int a, int b) {
+                int da = matrix(node, a), db = matrix(node, b);
+                return da < db || (da == db && a < b);
+            };
+            std::partial_sort(candidates.begin(), candidates.begin() + width, candidates.end(), closer);
+            std::copy(candidates.begin(), candidates.begin() + width, data.begin() + size_t(node) * width);
+        });
+    }
+
+    // Candidates kept per node
+    int k() const { return width; }
+
+    const int* of(int node) const { return data.data() + size_t(node) * width; }
+
+private:
+    int width = 0;
+    int numNodes = 0;
+    std::vector<int> data;
+};
+
+#endif
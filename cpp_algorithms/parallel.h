@@ -0,0 +1,131 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <algorithm>
+
+// Reusable rendezvous point for a fixed group of threads. The last thread to
+// arrive runs the completion step before anyone is released, which gives
+// multi-chain solvers a race-free place to exchange state between phases.
+class Barrier {
+public:
+    explicit Barrier(int count) : count(count) {}
+
+    template <typename Completion>
+    void arriveAndWait(Completion completion) {
+        std::unique_lock<std::mutex> lock(mutex);
+        int myGeneration = generation;
+        if (++arrived == count) {
+            completion();
+            arrived = 0;
+            generation++;
+            released.notify_all();
+        } else {
+            released.wait(lock, [&] { return generation != myGeneration; });
+        }
+    }
+
+    void arriveAndWait() {
+        arriveAndWait([] {});
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable released;
+    int count;
+    int arrived = 0;
+    int generation = 0;
+};
+
+// Run body(i) for every i in [begin, end), split into one contiguous batch
+// per thread; the calling thread takes the first batch
+template <typename Body>
+void parallelFor(int begin, int end, int numThreads, Body body) {
+    int total = end - begin;
+    numThreads = std::max(1, std::min(numThreads, total));
+    if (numThreads == 1) {
+        for (int i = begin; i < end; i++) {
+            body(i);
+        }
+        return;
+    }
+
+    auto runBatch = [&](int t) {
+        int batchBegin = begin + int((long long)total * t / numThreads);
+        int batchEnd = begin + int((long long)total * (t + 1) / numThreads);
+        for (int i = batchBegin; i < batchEnd; i++) {
+            body(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numThreads; t++) {
+        threads.emplace_back(runBatch, t);
+    }
+    runBatch(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Run body(task, worker) for every task in order on numThreads workers with
+// work stealing. Tasks are dealt round-robin in the order given, so put the
+// expensive ones first. Each worker takes its own tasks from the front and,
+// once they run out, steals from the back of another worker's queue; a few
+// large tasks landing on one worker then never leave the others idle while
+// work remains. The calling thread is worker 0
+template <typename Body>
+void workStealingFor(const std::vector<int>& order, int numThreads, Body body) {
+    numThreads = std::max(1, std::min<int>(numThreads, order.size()));
+    struct Lane {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+    std::vector<std::unique_ptr<Lane>> lanes;
+    for (int t = 0; t < numThreads; t++) {
+        lanes.emplace_back(new Lane());
+    }
+    for (size_t k = 0; k < order.size(); k++) {
+        lanes[k % numThreads]->tasks.push_back(order[k]);
+    }
+
+    // No task is added once workers start, so a full pass over every lane
+    // that finds nothing means the batch is done
+    auto next = [&](int worker, int& task) {
+        for (int offset = 0; offset < numThreads; offset++) {
+            Lane& lane = *lanes[(worker + offset) % numThreads];
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            if (!lane.tasks.empty()) {
+                if (offset == 0) {
+                    task = lane.tasks.front();
+                    lane.tasks.pop_front();
+                } else {
+                    task = lane.tasks.back();
+                    lane.tasks.pop_back();
+                }
+                return true;
+            }
+        }
+        return false;
+    };
+    auto run = [&](int worker) {
+        int task;
+        while (next(worker, task)) {
+            body(task, worker);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numThreads; t++) {
+        threads.emplace_back(run, t);
+    }
+    run(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+#endif
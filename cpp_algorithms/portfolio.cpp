@@ -0,0 +1,54 @@
+#include "portfolio.h"
+#include "local_search.h"
+
+// Usage: portfolio [numVehicles] [matrixFile] [--algorithms a,b,...] [--seed S]
+//          [--local-search [--ls-neighbors K] [--ls-segment L]]
+//          [--telemetry[=FILE]] [--time-limit SECONDS] [--stream]
+//          [--constraints FILE] [--distance-type auto|int32|uint16]
+// Races the algorithms (default nearest_neighbor, clarke_wright,
+// simulated_annealing, genetic_algorithm) on one thread each with a shared
+// incumbent (portfolio.h) and writes the winner's routes. The runs go to
+// stderr as one JSON line: {"winner": ..., "distance": ..., "runs": [...]}.
+int main(int argc, char** argv) try {
+    CommandLine commandLine = parseCommandLine(argc, argv);
+    SolveControl control;
+    configureControl(commandLine, control);
+    Telemetry telemetry;
+    Telemetry* probe = telemetryFromCommandLine(commandLine, telemetry);
+    auto stored = timePhase(probe, "parse", [&] {
+        return loadDistanceMatrix(commandLine.matrixFile, commandLine.get("distance-type", "auto"));
+    });
+    return stored.visit([&](const auto& matrix) {
+        int numVehicles = commandLine.numVehicles;
+        Constraints constraints;
+        const Constraints* limits = constraintsFromCommandLine(commandLine, matrix, constraints);
+
+        PortfolioParams params;
+        if (commandLine.has("algorithms")) {
+            params.algorithms.clear();
+            std::stringstream names(commandLine.get("algorithms"));
+            std::string name;
+            while (std::getline(names, name, ',')) {
+                if (!name.empty()) params.algorithms.push_back(name);
+            }
+        }
+        params.seed = commandLine.getNumber("seed", params.seed);
+        params.constraints = limits;
+        params.control = &control;
+
+        PortfolioResult race =
+            timePhase(probe, "construct", [&] { return portfolioRace(matrix, numVehicles, params); });
+        std::cerr << "{\"winner\":" << jsonQuote(race.winner) << ",\"distance\":" << race.distance
+                  << ",\"runs\":" << portfolioRunsToJson(race.runs) << "}" << std::endl;
+        auto routes = race.routes;
+        applyLocalSearchOption(commandLine, matrix, routes, nullptr, probe, &control, limits);
+        warnViolations(limits, routes, matrix);
+        timePhase(probe, "write", [&] { writeRoutes(routes); });
+        writeTelemetry(commandLine, probe, "portfolio", matrix);
+
+        return 0;
+    });
+} catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+}
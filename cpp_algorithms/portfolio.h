@@ -0,0 +1,245 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include "brute_force.h"
+#include "nearest_neighbor.h"
+#include "clarke_wright.h"
+#include "genetic_algorithm.h"
+#include "simulated_annealing.h"
+#include <condition_variable>
+#include <thread>
+
+// Tuning knobs for portfolioRace
+struct PortfolioParams {
+    std::vector<std::string> algorithms = {"nearest_neighbor", "clarke_wright", "simulated_annealing",
+                                           "genetic_algorithm"};
+    unsigned seed = 0;                        // Seeds SA and the GA; 0 seeds from the clock
+    const Constraints* constraints = nullptr; // Solvers that ignore them sit the race out
+    const SolveControl* control = nullptr;    // Budget and cancellation of the race; streams the incumbent
+};
+
+// How one solver of the race did
+struct PortfolioRun {
+    std::string algorithm;
+    std::string status;        // "finished", "stopped" (by the budget or a cancel), "skipped" or "failed"
+    int distance = -1;         // Of its own final routes; -1 without any
+    double elapsedMs = 0.0;    // From the start of the race until it returned
+    std::string error;         // Why it was skipped or failed
+};
+
+struct PortfolioResult {
+    std::vector<std::vector<int>> routes;
+    int distance = 0;
+    std::string winner;        // Solver that found routes
+    std::vector<PortfolioRun> runs;
+};
+
+// Solvers runPortfolioSolver can race
+inline bool isPortfolioSolver(const std::string& algorithm) {
+    return algorithm == "nearest_neighbor" || algorithm == "clarke_wright" || algorithm == "simulated_annealing" ||
+           algorithm == "genetic_algorithm" || algorithm == "brute_force";
+}
+
+// Solvers that build routes within capacity and time windows
+inline bool portfolioHonoursConstraints(const std::string& algorithm) {
+    return algorithm == "nearest_neighbor" || algorithm == "clarke_wright";
+}
+
+// One solver of the race; the metaheuristics follow the shared incumbent
+template <typename Matrix>
+std::vector<std::vector<int>> runPortfolioSolver(const std::string& algorithm, const Matrix& matrix, int numVehicles,
+                                                 const PortfolioParams& params, const SolveControl* control,
+                                                 const Incumbent* incumbent) {
+    if (algorithm == "nearest_neighbor") {
+        NearestNeighborParams solver;
+        solver.constraints = params.constraints;
+        return nearestNeighborVRP(matrix, numVehicles, solver);
+    }
+    if (algorithm == "clarke_wright") {
+        ClarkeWrightParams solver;
+        solver.constraints = params.constraints;
+        return clarkeWrightVRP(matrix, numVehicles, solver);
+    }
+    if (algorithm == "simulated_annealing") {
+        AnnealingParams solver;
+        solver.seed = params.seed;
+        solver.control = control;
+        solver.incumbent = incumbent;
+        return simulatedAnnealingVRP(matrix, numVehicles, solver);
+    }
+    if (algorithm == "genetic_algorithm") {
+        GeneticParams solver;
+        solver.seed = params.seed;
+        solver.control = control;
+        solver.incumbent = incumbent;
+        if (control->hasDeadline()) {
+            solver.generations = 0;
+        }
+        return geneticAlgorithmVRP(matrix, numVehicles, solver);
+    }
+    if (algorithm == "brute_force") {
+        return bruteForceVRP(matrix, numVehicles);
+    }
+    throw std::runtime_error("Unknown algorithm: " + algorithm);
+}
+
+// Race several solvers on one instance, one thread each, and keep the best
+// routes any of them finds within the budget
+// Every solution a solver finds is offered to a shared Incumbent. The
+// constructive solvers finish within milliseconds, and SA and the GA pick
+// their routes up at their next cooling step or generation and improve from
+// there instead of from a random start. Every solver gets the caller's
+// deadline; a cancel or stop signal is passed on to all of them at once.
+// The metaheuristics stop at their next check. A constructive pass cannot be
+// interrupted, so the race returns once every solver has returned. The
+// winner is the solver that offered the final incumbent, even when it started
+// from another solver's routes.
+template <typename Matrix>
+PortfolioResult portfolioRace(const Matrix& matrix, int numVehicles, const PortfolioParams& params) {
+    for (const auto& algorithm : params.algorithms) {
+        if (!isPortfolioSolver(algorithm)) {
+            throw std::runtime_error("Unknown algorithm: " + algorithm);
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    Incumbent incumbent;
+    size_t count = params.algorithms.size();
+    std::vector<PortfolioRun> runs(count);
+    std::vector<std::unique_ptr<SolveControl>> controls(count);
+    std::mutex mutex;
+    std::condition_variable done;
+    int running = 0;
+
+    // Offered solutions that take the lead are streamed through the caller's control
+    auto offer = [&](const std::vector<std::vector<int>>& routes, int distance, const std::string& algorithm) {
+        if (incumbent.offer(routes, distance, algorithm) && params.control != nullptr) {
+            params.control->reportImprovement(routes, distance);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t k = 0; k < count; k++) {
+        const std::string& algorithm = params.algorithms[k];
+        runs[k].algorithm = algorithm;
+        if (params.constraints != nullptr && params.constraints->active() && !portfolioHonoursConstraints(algorithm)) {
+            runs[k].status = "skipped";
+            runs[k].error = "ignores capacity and time windows";
+            continue;
+        }
+        controls[k].reset(new SolveControl());
+        if (params.control != nullptr && params.control->hasDeadline()) {
+            controls[k]->setTimeLimit(params.control->remainingSeconds());
+        }
+        controls[k]->onImprovement([&, k](const std::vector<std::vector<int>>& routes, int distance) {
+            offer(routes, distance, params.algorithms[k]);
+        });
+        running++;
+        threads.emplace_back([&, k] {
+            PortfolioRun& run = runs[k];
+            try {
+                auto routes = runPortfolioSolver(run.algorithm, matrix, numVehicles, params, controls[k].get(),
+                                                 &incumbent);
+                run.distance = calculateTotalDistance(routes, matrix);
+                run.status = controls[k]->stopRequested() ? "stopped" : "finished";
+                offer(routes, run.distance, run.algorithm);
+            } catch (const std::exception& e) {
+                run.status = "failed";
+                run.error = e.what();
+            }
+            run.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running--;
+            }
+            done.notify_all();
+        });
+    }
+
+    // The deadline is already shared; watch for a cancel or a stop signal
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running > 0) {
+            done.wait_for(lock, std::chrono::milliseconds(5));
+            if (stopRequested(params.control)) {
+                for (auto& control : controls) {
+                    if (control != nullptr) control->cancel();
+                }
+            }
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    Incumbent::Solution best;
+    if (!incumbent.read(best)) {
+        std::string reason = "no algorithm to race";
+        for (const auto& run : runs) {
+            if (!run.error.empty()) {
+                reason = run.algorithm + ": " + run.error;
+                break;
+            }
+        }
+        throw std::runtime_error("Portfolio found no solution (" + reason + ")");
+    }
+    PortfolioResult result;
+    result.routes = std::move(best.routes);
+    result.distance = best.distance;
+    result.winner = best.source;
+    result.runs = std::move(runs);
+    return result;
+}
+
+// The racers as "a,b,...", to tell portfolio solves apart in cache keys
+inline std::string portfolioRacerList(const PortfolioParams& params) {
+    std::string list;
+    for (const auto& algorithm : params.algorithms) {
+        list += (list.empty() ? "" : ",") + algorithm;
+    }
+    return list;
+}
+
+// The race's runs as a JSON array, for the daemon and the portfolio binary
+inline std::string portfolioRunsToJson(const std::vector<PortfolioRun>& runs) {
+    std::string json = "[";
+    for (size_t k = 0; k < runs.size(); k++) {
+        const PortfolioRun& run = runs[k];
+        json += (k > 0 ? ",{\"algorithm\":" : "{\"algorithm\":") + jsonQuote(run.algorithm) +
+                ",\"status\":" + jsonQuote(run.status);
+        if (run.distance >= 0) {
+            json += ",\"distance\":" + std::to_string(run.distance);
+        }
+        json += ",\"elapsed_ms\":" + std::to_string(run.elapsedMs);
+        if (!run.error.empty()) {
+            json += ",\"error\":" + jsonQuote(run.error);
+        }
+        json += "}";
+    }
+    return json + "]";
+}
+
+// Registry variants (solvers.h): the default portfolio, with the caller's
+// budget or under constraints
+template <typename Matrix>
+std::vector<std::vector<int>> portfolioVRP(const Matrix& matrix, int numVehicles) {
+    return portfolioRace(matrix, numVehicles, PortfolioParams()).routes;
+}
+
+template <typename Matrix>
+std::vector<std::vector<int>> portfolioAnytime(const Matrix& matrix, int numVehicles, const SolveControl* control,
+                                               unsigned seed) {
+    PortfolioParams params;
+    params.control = control;
+    params.seed = seed;
+    return portfolioRace(matrix, numVehicles, params).routes;
+}
+
+template <typename Matrix>
+std::vector<std::vector<int>> portfolioConstrained(const Matrix& matrix, int numVehicles,
+                                                   const Constraints* constraints) {
+    PortfolioParams params;
+    params.constraints = constraints;
+    return portfolioRace(matrix, numVehicles, params).routes;
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include "reoptimize.h"
+#include <sstream>
+
+// Usage: reoptimize [numVehicles] [matrixFile] [--previous output.txt]
+//          [--add 12,13] [--remove 4] [--no-search] [--ls-neighbors K] [--ls-segment L]
+//          [--constraints FILE] [--telemetry[=FILE]] [--time-limit SECONDS] [--stream]
+//          [--distance-type auto|int32|uint16]
+//
+// Warm start after orders change: reads the previous routes, drops the
+// removed stops, inserts the added ones (node numbers in matrixFile) and
+// improves around the change, then writes output.txt. numVehicles is the
+// new fleet size; without it the previous routes' fleet is kept, and the
+// matrix file may be given alone: reoptimize input.bin --previous ...
+std::vector<int> parseNodeList(const std::string& text) {
+    std::vector<int> nodes;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) nodes.push_back(std::stoi(item));
+    }
+    return nodes;
+}
+
+int main(int argc, char** argv) try {
+    CommandLine commandLine = parseCommandLine(argc, argv);
+    SolveControl control;
+    configureControl(commandLine, control);
+    Telemetry telemetry;
+    Telemetry* probe = telemetryFromCommandLine(commandLine, telemetry);
+    auto stored = timePhase(probe, "parse", [&] {
+        return loadDistanceMatrix(commandLine.matrixFile, commandLine.get("distance-type", "auto"));
+    });
+    return stored.visit([&](const auto& matrix) {
+        auto previous = readRoutes(commandLine.get("previous", "output.txt"));
+        Constraints constraints;
+        const Constraints* limits = constraintsFromCommandLine(commandLine, matrix, constraints);
+
+        RouteChange change;
+        change.added = parseNodeList(commandLine.get("add"));
+        change.removed = parseNodeList(commandLine.get("remove"));
+        change.numVehicles = commandLine.hasNumVehicles ? commandLine.numVehicles : 0;
+
+        ReoptimizeParams params;
+        params.improve = !commandLine.has("no-search");
+        params.neighbors = commandLine.getNumber("ls-neighbors", params.neighbors);
+        params.maxSegment = commandLine.getNumber("ls-segment", params.maxSegment);
+        params.telemetry = probe;
+        params.control = &control;
+        params.constraints = limits;
+
+        auto routes = timePhase(probe, "reoptimize", [&] { return reoptimizeRoutes(matrix, previous, change, params); });
+        warnViolations(limits, routes, matrix);
+        timePhase(probe, "write", [&] { writeRoutes(routes); });
+        writeTelemetry(commandLine, probe, "reoptimize", matrix);
+
+        return 0;
+    });
+} catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+}
@@ -0,0 +1,208 @@
+#ifndef REOPTIMIZE_H
+#define REOPTIMIZE_H
+
+#include "local_search.h"
+#include <unordered_set>
+
+// A change to a solved instance. Node numbers index the current matrix, which
+// must cover the added stops; removed stops may stay in it.
+struct RouteChange {
+    std::vector<int> added;     // Stops to serve that the previous routes do not visit
+    std::vector<int> removed;   // Stops to drop from the previous routes
+    int numVehicles = 0;        // New fleet size; 0 keeps one route per previous route
+};
+
+// Tuning knobs for reoptimizeRoutes
+struct ReoptimizeParams {
+    bool improve = true;                      // Run the local search around the change
+    int neighbors = 20;                       // Candidate partners per node in that search
+    int maxSegment = 3;                       // Longest chain moved by its Or-opt
+    Telemetry* telemetry = nullptr;           // Phase times and insertion/move counters
+    const SolveControl* control = nullptr;    // Deadline for the search; the result is streamed
+    const Constraints* constraints = nullptr; // Capacity/time windows insertions must respect
+};
+
+// Warm start: apply a change to previous routes instead of solving again
+// Removed stops are cut out, and when the fleet shrinks the routes with the
+// fewest stops are dissolved. Added and displaced stops then go in by cheapest
+// insertion: each pending stop caches its best position, and after a stop is
+// placed only that route is re-priced for the others (a stop whose cached
+// position was in it is re-priced everywhere). With constraints the added
+// violation is compared first and distance second. Finally the local search
+// starts from the inserted stops and the neighbours of removed ones only, so
+// the work grows with the size of the change rather than with N.
+template <typename Matrix>
+std::vector<std::vector<int>> reoptimizeRoutes(const Matrix& matrix,
+                                               const std::vector<std::vector<int>>& previous,
+                                               const RouteChange& change, const ReoptimizeParams& params) {
+    const Constraints* constraints =
+        params.constraints != nullptr && params.constraints->active() ? params.constraints : nullptr;
+    auto checkNode = [&](int node, const char* what) {
+        if (node < 1 || node > matrix.customers()) {
+            throw std::runtime_error(std::string(what) + " stop " + std::to_string(node) + " is not in the matrix");
+        }
+    };
+
+    // Previous routes with the removed stops cut out; routes keep explicit depot endpoints
+    std::unordered_set<int> removed(change.removed.begin(), change.removed.end());
+    std::unordered_set<int> visited;
+    std::vector<int> focus;
+    std::vector<std::vector<int>> routes;
+    for (const auto& route : previous) {
+        std::vector<int> nodes = {0};
+        bool gap = false;   // The previous stop was removed
+        for (int node : route) {
+            if (node == 0) continue;
+            checkNode(node, "Routed");
+            if (!visited.insert(node).second) {
+                throw std::runtime_error("Stop " + std::to_string(node) + " appears twice in the previous routes");
+            }
+            if (removed.count(node)) {
+                focus.push_back(nodes.back());
+                gap = true;
+                continue;
+            }
+            if (gap) focus.push_back(node);
+            gap = false;
+            nodes.push_back(node);
+        }
+        nodes.push_back(0);
+        routes.push_back(std::move(nodes));
+    }
+    for (int node : change.removed) {
+        checkNode(node, "Removed");
+        visited.erase(node);
+    }
+
+    // visited now holds the stops still routed; each added stop joins it
+    std::vector<int> pending;
+    for (int node : change.added) {
+        checkNode(node, "Added");
+        if (!visited.insert(node).second) {
+            throw std::runtime_error("Added stop " + std::to_string(node) + " is already routed or added twice");
+        }
+        pending.push_back(node);
+    }
+
+    // Fleet size: open empty routes, or dissolve the smallest ones
+    int numVehicles = change.numVehicles > 0 ? change.numVehicles : int(routes.size());
+    while (int(routes.size()) < numVehicles) {
+        routes.push_back({0, 0});
+    }
+    if (int(routes.size()) > numVehicles) {
+        std::stable_sort(routes.begin(), routes.end(),
+                         [](const std::vector<int>& a, const std::vector<int>& b) { return a.size() > b.size(); });
+        for (size_t r = numVehicles; r < routes.size(); r++) {
+            pending.insert(pending.end(), routes[r].begin() + 1, routes[r].end() - 1);
+        }
+        routes.resize(numVehicles);
+    }
+
+    // Cheapest insertion with a cached best position per pending stop
+    struct Insertion {
+        int violation = std::numeric_limits<int>::max();
+        int cost = std::numeric_limits<int>::max();
+        int route = -1;
+        int position = 0;   // Insert before routes[route][position]
+
+        bool operator<(const Insertion& other) const {
+            return violation != other.violation ? violation < other.violation : cost < other.cost;
+        }
+    };
+    std::vector<std::vector<RouteSegment>> prefix(routes.size()), suffix(routes.size());
+    std::vector<int> violation(routes.size(), 0);
+    auto summarize = [&](int r) {
+        if (constraints == nullptr) return;
+        const auto& nodes = routes[r];
+        size_t size = nodes.size();
+        prefix[r].resize(size);
+        suffix[r].resize(size);
+        prefix[r][0] = constraints->node(nodes[0]);
+        suffix[r][size - 1] = constraints->node(nodes[size - 1]);
+        for (size_t i = 1; i < size; i++) {
+            prefix[r][i] = constraints->join(prefix[r][i - 1], constraints->node(nodes[i]), matrix);
+            suffix[r][size - 1 - i] = constraints->join(constraints->node(nodes[size - 1 - i]), suffix[r][size - i],
+                                                        matrix);
+        }
+        violation[r] = constraints->violation(prefix[r][size - 1]);
+    };
+    auto bestIn = [&](int stop, int r, Insertion& best) {
+        const auto& nodes = routes[r];
+        RouteSegment node = constraints != nullptr ? constraints->node(stop) : RouteSegment();
+        for (size_t i = 1; i < nodes.size(); i++) {
+            Insertion candidate;
+            candidate.cost = matrix(nodes[i - 1], stop) + matrix(stop, nodes[i]) - matrix(nodes[i - 1], nodes[i]);
+            candidate.violation = 0;
+            if (constraints != nullptr) {
+                RouteSegment joined = constraints->join(constraints->join(prefix[r][i - 1], node, matrix),
+                                                        suffix[r][i], matrix);
+                candidate.violation = constraints->violation(joined) - violation[r];
+            }
+            candidate.route = r;
+            candidate.position = i;
+            if (candidate < best) best = candidate;
+        }
+    };
+    auto bestAnywhere = [&](int stop) {
+        Insertion best;
+        for (size_t r = 0; r < routes.size(); r++) {
+            bestIn(stop, r, best);
+        }
+        return best;
+    };
+
+    std::vector<Insertion> cached;
+    int inserted = pending.size();
+    if (!pending.empty()) {
+        for (size_t r = 0; r < routes.size(); r++) {
+            summarize(r);
+        }
+        for (int stop : pending) {
+            cached.push_back(bestAnywhere(stop));
+        }
+    }
+    while (!pending.empty()) {
+        size_t pick = std::min_element(cached.begin(), cached.end()) - cached.begin();
+        Insertion chosen = cached[pick];
+        int stop = pending[pick];
+        pending.erase(pending.begin() + pick);
+        cached.erase(cached.begin() + pick);
+
+        int r = chosen.route;
+        routes[r].insert(routes[r].begin() + chosen.position, stop);
+        summarize(r);
+        focus.push_back(stop);
+        for (size_t k = 0; k < pending.size(); k++) {
+            if (cached[k].route == r) {
+                cached[k] = bestAnywhere(pending[k]);
+            } else {
+                bestIn(pending[k], r, cached[k]);
+            }
+        }
+    }
+    if (params.telemetry != nullptr) {
+        params.telemetry->setCounter("inserted", inserted);
+    }
+
+    if (params.improve && !focus.empty()) {
+        LocalSearchParams search;
+        search.neighbors = params.neighbors;
+        search.maxSegment = params.maxSegment;
+        search.telemetry = params.telemetry;
+        search.control = params.control;
+        search.constraints = params.constraints;
+        search.focus = &focus;
+        return localSearchVRP(matrix, routes, search);
+    }
+    reportRoutes(params.control, matrix, routes);
+    return routes;
+}
+
+template <typename Matrix>
+std::vector<std::vector<int>> reoptimizeRoutes(const Matrix& matrix,
+                                               const std::vector<std::vector<int>>& previous,
+                                               const RouteChange& change) {
+    return reoptimizeRoutes(matrix, previous, change, ReoptimizeParams());
+}
+
+#endif
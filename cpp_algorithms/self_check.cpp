@@ -0,0 +1,242 @@
+#include "brute_force.h"
+#include "constraints.h"
+#include <functional>
+
+// Usage: self_check [--seed S] [--rounds R]
+// Compares the fast solvers against slow, obviously correct references on
+// small random instances (the exact solver against exhaustive search, the
+// O(1) segment checks of constraints.h against a stop-by-stop rescan) and
+// exits with 1 on the first mismatch. Run by
+// build_all.sh after the build.
+
+// Random asymmetric instance; with depotShortcuts the depot sits close to
+// every stop while the stops are far apart, so the best split uses several
+// routes. Without, the depot legs are long enough that one route is optimal.
+DistanceMatrix randomInstance(int customers, bool depotShortcuts, std::mt19937& random) {
+    std::uniform_int_distribution<int> near(5, 20), far(40, 100);
+    DistanceMatrix matrix(customers);
+    for (int i = 0; i <= customers; i++) {
+        for (int j = 0; j <= customers; j++) {
+            if (i == j) continue;
+            bool depotLeg = i == 0 || j == 0;
+            matrix.set(i, j, depotLeg == depotShortcuts ? near(random) : far(random));
+        }
+    }
+    return matrix;
+}
+
+// Cheapest single route through each subset of stops (bit i - 1 for stop
+// i), with every visiting order tried
+std::vector<int> exhaustiveRouteCosts(const DistanceMatrix& matrix) {
+    int n = matrix.customers();
+    std::vector<int> routeCost(1 << n, std::numeric_limits<int>::max());
+    routeCost[0] = 0;
+    for (int mask = 1; mask < (1 << n); mask++) {
+        std::vector<int> stops;
+        for (int i = 0; i < n; i++) {
+            if (mask >> i & 1) stops.push_back(i + 1);
+        }
+        do {
+            routeCost[mask] = std::min(routeCost[mask], calculateRouteDistance(stops, matrix));
+        } while (std::next_permutation(stops.begin(), stops.end()));
+    }
+    return routeCost;
+}
+
+// Cheapest total distance over every split of n stops into at most
+// numVehicles routes; stops are assigned one at a time to an open route or
+// a new one
+int exhaustiveOptimum(const std::vector<int>& routeCost, int n, int numVehicles) {
+    int best = std::numeric_limits<int>::max();
+    std::vector<int> routes;
+    std::function<void(int)> assign = [&](int stop) {
+        if (stop == n) {
+            int total = 0;
+            for (int mask : routes) total += routeCost[mask];
+            best = std::min(best, total);
+            return;
+        }
+        for (size_t r = 0; r < routes.size(); r++) {
+            routes[r] |= 1 << stop;
+            assign(stop + 1);
+            routes[r] &= ~(1 << stop);
+        }
+        if (int(routes.size()) < numVehicles) {
+            routes.push_back(1 << stop);
+            assign(stop + 1);
+            routes.pop_back();
+        }
+    };
+    assign(0);
+    return best;
+}
+
+// bruteForceVRP must visit every stop once, in at most numVehicles routes,
+// at the exhaustive optimum
+void checkExactSolver(std::mt19937& random, int rounds) {
+    int checked = 0;
+    for (int round = 0; round < rounds; round++) {
+        for (int customers : {8, 9, 10}) {
+            for (bool depotShortcuts : {true, false}) {
+                DistanceMatrix matrix = randomInstance(customers, depotShortcuts, random);
+                std::vector<int> routeCost = exhaustiveRouteCosts(matrix);
+                for (int numVehicles = 1; numVehicles <= 4; numVehicles++) {
+                    int optimum = exhaustiveOptimum(routeCost, customers, numVehicles);
+                    for (int threads : {1, 4}) {
+                        ExactParams params;
+                        params.threads = threads;
+                        auto routes = bruteForceVRP(matrix, numVehicles, params);
+                        std::vector<int> visits(customers + 1, 0);
+                        for (const auto& route : routes) {
+                            for (int stop : route) visits[stop]++;
+                        }
+                        std::string where = std::to_string(customers) + " stops, " + std::to_string(numVehicles) +
+                                            " vehicles, " + (depotShortcuts ? "with" : "without") +
+                                            " depot shortcuts, " + std::to_string(threads) + " threads";
+                        if (int(routes.size()) > numVehicles) {
+                            throw std::runtime_error("exact solver used too many routes (" + where + ")");
+                        }
+                        for (int i = 1; i <= customers; i++) {
+                            if (visits[i] != 1) {
+                                throw std::runtime_error("exact solver visits stop " + std::to_string(i) + " " +
+                                                         std::to_string(visits[i]) + " times (" + where + ")");
+                            }
+                        }
+                        int found = calculateTotalDistance(routes, matrix);
+                        if (found != optimum) {
+                            throw std::runtime_error("exact solver found " + std::to_string(found) +
+                                                     ", exhaustive search " + std::to_string(optimum) + " (" + where +
+                                                     ")");
+                        }
+                        checked++;
+                    }
+                }
+            }
+        }
+    }
+
+    // A fleet of fewer than one vehicle is refused rather than overrunning the round table
+    DistanceMatrix matrix = randomInstance(4, true, random);
+    for (int numVehicles : {0, -1}) {
+        bool refused = false;
+        try {
+            bruteForceVRP(matrix, numVehicles);
+        } catch (const std::runtime_error&) {
+            refused = true;
+        }
+        if (!refused) {
+            throw std::runtime_error("exact solver accepted " + std::to_string(numVehicles) + " vehicles");
+        }
+    }
+    std::cout << "exact solver: " << checked << " instances match exhaustive search" << std::endl;
+}
+
+// Excess load plus time warp of one route, found by driving it stop by stop:
+// leave the depot when it opens, wait for windows that are not yet open,
+// and travel back in time to the due time of any stop reached late
+int rescanViolation(const Constraints& constraints, const std::vector<int>& stops, const DistanceMatrix& matrix) {
+    int load = 0;
+    for (int stop : stops) load += constraints.demands[stop];
+    int violation = std::max(load - constraints.capacity, 0);
+    int time = constraints.ready[0] + constraints.service[0];
+    int previous = 0;
+    std::vector<int> visits = stops;
+    visits.push_back(0);
+    for (int stop : visits) {
+        time = std::max(time + matrix(previous, stop), constraints.ready[stop]);
+        if (time > constraints.due[stop]) {
+            violation += time - constraints.due[stop];
+            time = constraints.due[stop];
+        }
+        time += constraints.service[stop];
+        previous = stop;
+    }
+    return violation;
+}
+
+// Route of random stops cut into a prefix, a middle and a suffix; the
+// middle is reversed half the time, as 2-opt does. The pieces are summarised
+// the way local_search.h keeps them (prefixes left to right, suffixes right
+// to left) and joined in O(1); the result must match a rescan of the route.
+void checkSegmentFeasibility(std::mt19937& random, int rounds) {
+    const int customers = 30;
+    std::uniform_int_distribution<int> distance(1, 100), demand(1, 10), ready(0, 400), width(0, 200),
+        service(0, 20), length(1, 12);
+    DistanceMatrix matrix(customers);
+    Constraints constraints;
+    constraints.capacity = 30;
+    constraints.demands.assign(customers + 1, 0);
+    constraints.ready.assign(customers + 1, 0);
+    constraints.due.assign(customers + 1, 1000);
+    constraints.service.assign(customers + 1, 0);
+    for (int i = 0; i <= customers; i++) {
+        for (int j = 0; j <= customers; j++) {
+            if (i != j) matrix.set(i, j, distance(random));
+        }
+        if (i > 0) {
+            constraints.demands[i] = demand(random);
+            constraints.ready[i] = ready(random);
+            constraints.due[i] = constraints.ready[i] + width(random);
+            constraints.service[i] = service(random);
+        }
+    }
+    constraints.validate(matrix);
+
+    std::vector<int> nodes(customers);
+    for (int i = 0; i < customers; i++) nodes[i] = i + 1;
+    int checked = 0, feasible = 0;
+    for (int round = 0; round < rounds * 2000; round++) {
+        std::shuffle(nodes.begin(), nodes.end(), random);
+        int size = length(random);
+        std::vector<int> stops(nodes.begin(), nodes.begin() + size);
+        int cut1 = std::uniform_int_distribution<int>(0, size)(random);
+        int cut2 = std::uniform_int_distribution<int>(cut1, size)(random);
+        bool reversed = random() % 2 == 0;
+
+        RouteSegment prefix = constraints.node(0);
+        for (int k = 0; k < cut1; k++) {
+            prefix = constraints.join(prefix, constraints.node(stops[k]), matrix);
+        }
+        RouteSegment middle;
+        for (int k = cut1; k < cut2; k++) {
+            RouteSegment stop = constraints.node(stops[k]);
+            middle = reversed ? constraints.join(stop, middle, matrix) : constraints.join(middle, stop, matrix);
+        }
+        RouteSegment suffix = constraints.node(0);
+        for (int k = size - 1; k >= cut2; k--) {
+            suffix = constraints.join(constraints.node(stops[k]), suffix, matrix);
+        }
+        RouteSegment joined = constraints.join(constraints.join(prefix, middle, matrix), suffix, matrix);
+
+        if (reversed) {
+            std::reverse(stops.begin() + cut1, stops.begin() + cut2);
+        }
+        int expected = rescanViolation(constraints, stops, matrix);
+        int walked = constraints.violation(constraints.route(stops, matrix));
+        if (constraints.violation(joined) != expected || walked != expected) {
+            std::string route;
+            for (int stop : stops) route += " " + std::to_string(stop);
+            throw std::runtime_error("segment checks give " + std::to_string(constraints.violation(joined)) +
+                                     " joined and " + std::to_string(walked) + " walked, rescan " +
+                                     std::to_string(expected) + ", for route" + route);
+        }
+        checked++;
+        feasible += expected == 0;
+    }
+    std::cout << "segment feasibility: " << checked << " routes (" << feasible << " feasible) match a rescan"
+              << std::endl;
+}
+
+int main(int argc, char** argv) try {
+    CommandLine commandLine = parseCommandLine(argc, argv);
+    std::mt19937 random(commandLine.getNumber("seed", 1));
+    int rounds = commandLine.getNumber("rounds", 3);
+
+    checkExactSolver(random, rounds);
+    checkSegmentFeasibility(random, rounds);
+
+    return 0;
+} catch (const std::exception& e) {
+    std::cerr << "self_check failed: " << e.what() << std::endl;
+    return 1;
+}
@@ -1,186 +1,84 @@
-#include "common.h"
-#include<bits/stdc++.h>
+#include "simulated_annealing.h"
+#include "local_search.h"
+#include "sparse_matrix.h"
+#include <chrono>
 
-// Simulated Annealing for VRP
-std::vector<std::vector<int>> simulatedAnnealingVRP(const std::vector<std::vector<int>>& matrix, int numVehicles) {
-    int n = matrix.size();
-    
-    // Parameters for Simulated Annealing
-    const double INITIAL_TEMP = 1000.0;
-    const double COOLING_RATE = 0.99;
-    const double MIN_TEMP = 0.01;
-    const int ITERATIONS_PER_TEMP = 100;
-    
-    // Random generator
-    std::mt19937 gen(std::time(0));
-    std::uniform_real_distribution<> realDist(0.0, 1.0);
-    std::uniform_int_distribution<> intDist(0, n - 1);
-    
-    // Initialize solution (random assignment of nodes to vehicles)
-    std::vector<std::vector<int>> currentSolution(numVehicles);
-    std::vector<int> nodes;
-    for (int i = 1; i < n; i++) {
-        nodes.push_back(i);
-    }
-    std::shuffle(nodes.begin(), nodes.end(), gen);
-    
-    // Distribute nodes to vehicles
-    int nodesPerVehicle = nodes.size() / numVehicles;
-    int extraNodes = nodes.size() % numVehicles;
-    
-    int index = 0;
-    for (int v = 0; v < numVehicles; v++) {
-        currentSolution[v].push_back(0); // Start at depot
-        
-        int nodesToAdd = nodesPerVehicle + (v < extraNodes ? 1 : 0);
-        for (int i = 0; i < nodesToAdd && index < nodes.size(); i++) {
-            currentSolution[v].push_back(nodes[index++]);
-        }
-        
-        currentSolution[v].push_back(0); // Return to depot
-    }
-    
-    // Get total distance of a solution
-    auto getTotalDistance = [&](const std::vector<std::vector<int>>& solution) {
-        return calculateTotalDistance(solution, matrix);
-    };
-    
-    // Use std::function to enable recursion in lambda
-    std::function<std::vector<std::vector<int>>(const std::vector<std::vector<int>>&)> getNeighbor;
-    
-    getNeighbor = [&](const std::vector<std::vector<int>>& solution) {
-        std::vector<std::vector<int>> neighbor = solution;
-        
-        // Try a limited number of times to generate a valid neighbor
-        for (int attempts = 0; attempts < 10; attempts++) {
-            // Randomly select type of move
-            int moveType = intDist(gen) % 3;
-            
-            if (moveType == 0) {
-                // Swap two nodes within the same route
-                int routeIdx = intDist(gen) % numVehicles;
-                if (neighbor[routeIdx].size() <= 3) {
-                    // Route too short for swap, try again
-                    continue;
-                }
-                
-                // Exclude depot nodes (0th and last elements)
-                int pos1 = 1 + (intDist(gen) % (neighbor[routeIdx].size() - 2));
-                int pos2 = 1 + (intDist(gen) % (neighbor[routeIdx].size() - 2));
-                
-                std::swap(neighbor[routeIdx][pos1], neighbor[routeIdx][pos2]);
-                return neighbor;
-            }
-            else if (moveType == 1) {
-                // Move a node from one route to another
-                int srcRouteIdx = intDist(gen) % numVehicles;
-                int destRouteIdx = intDist(gen) % numVehicles;
-                
-                if (srcRouteIdx == destRouteIdx || neighbor[srcRouteIdx].size() <= 3) {
-                    // Cannot move from route with only one node or same route
-                    continue;
-                }
-                
-                // Select a node to move (exclude depot nodes)
-                int srcPos = 1 + (intDist(gen) % (neighbor[srcRouteIdx].size() - 2));
-                int node = neighbor[srcRouteIdx][srcPos];
-                
-                // Remove node from source route
-                neighbor[srcRouteIdx].erase(neighbor[srcRouteIdx].begin() + srcPos);
-                
-                // Insert node into destination route (before the last depot)
-                neighbor[destRouteIdx].insert(neighbor[destRouteIdx].end() - 1, node);
-                return neighbor;
-            }
-            else {
-                // 2-opt: Reverse a segment within a route
-                int routeIdx = intDist(gen) % numVehicles;
-                if (neighbor[routeIdx].size() <= 4) {
-                    // Route too short for 2-opt
-                    continue;
+// Usage: simulated_annealing [numVehicles] [matrixFile]
+//          [--chains N] [--seed S] [--temp T] [--cooling R] [--iterations I]
+//          [--spread X] [--exchange-interval K] [--scaling]
+//          [--local-search [--ls-neighbors K] [--ls-segment L]]
+//          [--telemetry[=FILE]] [--time-limit SECONDS] [--stream]
+//          [--constraints FILE] [--distance-type auto|int32|uint16]
+//          [--sparse K [--metric haversine|equirectangular]]
+// With --sparse K, matrixFile is a coordinates file ("lat lon" lines, depot
+// first) and only each stop's K nearest distances are stored (sparse_matrix.h).
+// Capacity and time windows from --constraints are enforced by the local
+// search stage, which repairs the annealed routes; without it they
+// are only checked.
+// --scaling reruns the solve with 1, 2, 4, ... up to N chains and prints
+// throughput and parallel efficiency for each thread count to stderr.
+int main(int argc, char** argv) try {
+    CommandLine commandLine = parseCommandLine(argc, argv);
+    SolveControl control;
+    configureControl(commandLine, control);
+    Telemetry telemetry;
+    Telemetry* probe = telemetryFromCommandLine(commandLine, telemetry);
+    auto solve = [&](const auto& matrix) {
+        int numVehicles = commandLine.numVehicles;
+        Constraints constraints;
+        const Constraints* limits = constraintsFromCommandLine(commandLine, matrix, constraints);
+
+        AnnealingParams params;
+        params.chains = commandLine.getNumber("chains", params.chains);
+        params.seed = commandLine.getNumber("seed", params.seed);
+        params.initialTemp = commandLine.getNumber("temp", params.initialTemp);
+        params.coolingRate = commandLine.getNumber("cooling", params.coolingRate);
+        params.iterationsPerTemp = commandLine.getNumber("iterations", params.iterationsPerTemp);
+        params.temperatureSpread = commandLine.getNumber("spread", params.temperatureSpread);
+        params.exchangeInterval = commandLine.getNumber("exchange-interval", params.exchangeInterval);
+        params.telemetry = probe;
+        params.control = &control;
+
+        if (commandLine.has("scaling")) {
+            // Parallel tempering does one chain's work per thread, so ideal
+            // scaling keeps wall time flat while total iterations grow with N
+            double baseRate = 0.0;
+            std::cerr << "threads,wall_ms,iterations,iterations_per_sec,efficiency,best_distance" << std::endl;
+            for (int threads = 1; threads <= params.chains; threads *= 2) {
+                AnnealingParams run = params;
+                run.chains = threads;
+                run.telemetry = nullptr;
+                run.control = nullptr;
+                AnnealingStats stats;
+                auto start = std::chrono::steady_clock::now();
+                auto routes = simulatedAnnealingVRP(matrix, numVehicles, run, &stats);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                double rate = stats.iterations / elapsed.count();
+                if (threads == 1) {
+                    baseRate = rate;
                 }
-                
-                // Exclude depot nodes
-                int pos1 = 1 + (intDist(gen) % (neighbor[routeIdx].size() - 2));
-                int pos2 = 1 + (intDist(gen) % (neighbor[routeIdx].size() - 2));
-                
-                if (pos1 > pos2) std::swap(pos1, pos2);
-                
-                // Reverse the segment
-                std::reverse(neighbor[routeIdx].begin() + pos1, neighbor[routeIdx].begin() + pos2 + 1);
-                return neighbor;
+                std::cerr << threads << "," << elapsed.count() * 1000 << "," << stats.iterations << ","
+                          << rate << "," << rate / (baseRate * threads) << ","
+                          << calculateTotalDistance(routes, matrix) << std::endl;
             }
         }
-        
-        // If we couldn't find a valid move after several attempts, just return the original
-        return solution;
+
+        auto routes = simulatedAnnealingVRP(matrix, numVehicles, params);
+        applyLocalSearchOption(commandLine, matrix, routes, nullptr, probe, &control, limits);
+        warnViolations(limits, routes, matrix);
+        timePhase(probe, "write", [&] { writeRoutes(routes); });
+        writeTelemetry(commandLine, probe, "simulated_annealing", matrix);
+
+        return 0;
     };
-    
-    // Simulated Annealing main loop
-    auto bestSolution = currentSolution;
-    int currentDistance = getTotalDistance(currentSolution);
-    int bestDistance = currentDistance;
-    
-    double temp = INITIAL_TEMP;
-    
-    while (temp > MIN_TEMP) {
-        for (int i = 0; i < ITERATIONS_PER_TEMP; i++) {
-            // Generate a neighbor solution
-            auto neighbor = getNeighbor(currentSolution);
-            int neighborDistance = getTotalDistance(neighbor);
-            
-            // Decide if we should accept the neighbor
-            if (neighborDistance < currentDistance) {
-                // Accept better solution
-                currentSolution = neighbor;
-                currentDistance = neighborDistance;
-                
-                if (currentDistance < bestDistance) {
-                    bestSolution = currentSolution;
-                    bestDistance = currentDistance;
-                }
-            } else {
-                // Accept worse solution with some probability
-                double p = exp((currentDistance - neighborDistance) / temp);
-                if (realDist(gen) < p) {
-                    currentSolution = neighbor;
-                    currentDistance = neighborDistance;
-                }
-            }
-        }
-        
-        // Cool down
-        temp *= COOLING_RATE;
+    if (commandLine.has("sparse")) {
+        return solve(timePhase(probe, "parse", [&] { return sparseMatrixFromCommandLine(commandLine); }));
     }
-    
-    return bestSolution;
+    auto stored = timePhase(probe, "parse", [&] {
+        return loadDistanceMatrix(commandLine.matrixFile, commandLine.get("distance-type", "auto"));
+    });
+    return stored.visit(solve);
+} catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
 }
-
-int main(int argc, char** argv) {
-    auto matrix = readDistanceMatrix();
-    
-    // Default to 2 vehicles
-    int numVehicles = 2;
-    
-    // Use command line argument if provided
-    if (argc > 1) {
-        numVehicles = std::atoi(argv[1]);
-    }
-    
-    // For brute force, check if problem size is manageable
-    if (matrix.size() > 10 && std::string(argv[0]).find("brute_force") != std::string::npos) {
-        std::cerr << "Warning: Brute force is impractical for " << matrix.size() 
-                  << " nodes. Using " << numVehicles << " vehicles and limiting to first 8 nodes." << std::endl;
-        
-        // Truncate the matrix to avoid excessive computation
-        if (matrix.size() > 8) {
-            matrix.resize(8);
-        }
-    }
-    
-    // Run the appropriate algorithm (already defined in each file)
-    auto routes = simulatedAnnealingVRP(matrix, numVehicles);
-    writeRoutes(routes);
-    
-    return 0;
-}
\ No newline at end of file
@@ -0,0 +1,446 @@
+#ifndef SIMULATED_ANNEALING_H
+#define SIMULATED_ANNEALING_H
+
+#include "common.h"
+#include "parallel.h"
+#include "telemetry.h"
+#include "control.h"
+
+// Tuning knobs for simulatedAnnealingVRP
+struct AnnealingParams {
+    double initialTemp = 1000.0;
+    double coolingRate = 0.99;
+    double minTemp = 0.01;
+    int iterationsPerTemp = 100;
+    unsigned seed = 0;               // 0 seeds from the clock
+    int chains = 1;                  // >1 runs parallel tempering, one thread per chain
+    double temperatureSpread = 10.0; // Hottest chain runs this many times hotter than the coldest
+    int exchangeInterval = 10;       // Cooling steps between replica exchanges
+    Telemetry* telemetry = nullptr;  // Phase times, acceptance per cooling step, best over time
+    const SolveControl* control = nullptr; // Deadline/cancellation and streamed improvements
+    const Incumbent* incumbent = nullptr;  // Shared best of a race; a chain restarts from it when it is better
+};
+
+// Work counters filled in by simulatedAnnealingVRP when requested
+struct AnnealingStats {
+    long long iterations = 0;
+    long long exchangesAttempted = 0;
+    long long exchangesAccepted = 0;
+};
+
+// One annealing chain
+// Each iteration proposes a swap, relocate or 2-opt move, prices it from the
+// handful of edges it touches and only then applies it in place. Routes keep
+// their depot endpoints and reserve room for every node up front, so the main
+// loop never allocates. Every chain owns its RNG stream, so a run is
+// reproducible for a given seed no matter how threads are scheduled.
+template <typename Matrix>
+class AnnealingChain {
+public:
+    AnnealingChain(const Matrix& matrix, int numVehicles, unsigned seed, int chainIndex)
+        : matrix(matrix), numVehicles(numVehicles), n(matrix.customers()) {
+        std::seed_seq seeds{seed, unsigned(chainIndex)};
+        gen.seed(seeds);
+
+        // Initialize solution (random assignment of nodes to vehicles)
+        currentSolution.resize(numVehicles);
+        std::vector<int> nodes;
+        for (int i = 1; i <= n; i++) {
+            nodes.push_back(i);
+        }
+        std::shuffle(nodes.begin(), nodes.end(), gen);
+
+        // Distribute nodes to vehicles
+        int nodesPerVehicle = nodes.size() / numVehicles;
+        int extraNodes = nodes.size() % numVehicles;
+
+        int index = 0;
+        for (int v = 0; v < numVehicles; v++) {
+            currentSolution[v].reserve(n + 2);
+            currentSolution[v].push_back(0); // Start at depot
+
+            int nodesToAdd = nodesPerVehicle + (v < extraNodes ? 1 : 0);
+            for (int i = 0; i < nodesToAdd && index < int(nodes.size()); i++) {
+                currentSolution[v].push_back(nodes[index++]);
+            }
+
+            currentSolution[v].push_back(0); // Return to depot
+        }
+
+        // The best solution is copied lazily: only when the chain is about to
+        // leave a new best state, or when it is read
+        bestSolution = currentSolution;
+        for (auto& route : bestSolution) {
+            route.reserve(n + 2);
+        }
+        currentDistance = calculateTotalDistance(currentSolution, matrix);
+        bestDistance = currentDistance;
+    }
+
+    // Run a fixed number of Metropolis iterations at one temperature
+    void anneal(double temp, int iterations) {
+        for (int i = 0; i < iterations; i++) {
+            step(temp);
+        }
+        iterationCount += iterations;
+    }
+
+    int distance() const { return currentDistance; }
+
+    int best() const { return bestDistance; }
+
+    long long iterations() const { return iterationCount; }
+
+    long long proposed() const { return proposedMoves; }
+
+    long long accepted() const { return acceptedMoves; }
+
+    const std::vector<std::vector<int>>& bestRoutes() {
+        flushBest();
+        return bestSolution;
+    }
+
+    // Continue from the shared incumbent when a new one beats this chain's best
+    void follow(const Incumbent& incumbent) {
+        unsigned version = incumbent.version();
+        if (version == seenVersion) {
+            return;
+        }
+        seenVersion = version;
+        Incumbent::Solution shared;
+        if (incumbent.distance() < bestDistance && incumbent.read(shared)) {
+            adopt(shared.routes);
+        }
+    }
+
+    // Replica exchange: trade current states with another chain
+    void swapState(AnnealingChain& other) {
+        flushBest();
+        other.flushBest();
+        std::swap(currentSolution, other.currentSolution);
+        std::swap(currentDistance, other.currentDistance);
+    }
+
+private:
+    const Matrix& matrix;
+    int numVehicles;
+    int n;
+    std::mt19937 gen;
+    std::uniform_real_distribution<> realDist{0.0, 1.0};
+    std::vector<std::vector<int>> currentSolution;
+    std::vector<std::vector<int>> bestSolution;
+    int currentDistance = 0;
+    int bestDistance = 0;
+    bool bestPending = false;
+    long long iterationCount = 0;
+    long long proposedMoves = 0;   // Moves that were priced
+    long long acceptedMoves = 0;
+    unsigned seenVersion = 0;      // Incumbent version last looked at
+
+    int randomIndex(int bound) {
+        return std::uniform_int_distribution<>(0, bound - 1)(gen);
+    }
+
+    void flushBest() {
+        if (bestPending) {
+            bestSolution = currentSolution;
+            bestPending = false;
+        }
+    }
+
+    // Restart from another solver's routes, fitted to numVehicles routes: a
+    // missing route starts empty and surplus routes are appended to the last one
+    void adopt(const std::vector<std::vector<int>>& routes) {
+        flushBest();
+        for (int v = 0; v < numVehicles; v++) {
+            auto& route = currentSolution[v];
+            route.assign(1, 0);
+            for (size_t r = v; r < routes.size() && (r == size_t(v) || v == numVehicles - 1); r++) {
+                for (int node : routes[r]) {
+                    if (node != 0) route.push_back(node);
+                }
+            }
+            route.push_back(0);
+        }
+        currentDistance = calculateTotalDistance(currentSolution, matrix);
+        if (currentDistance < bestDistance) {
+            bestDistance = currentDistance;
+            bestPending = true;
+        }
+    }
+
+    // Cost change of reversing route[i..j]; the interior edges only change
+    // cost when the matrix is asymmetric
+    int reversalDelta(const std::vector<int>& route, int i, int j) const {
+        int delta = matrix(route[i - 1], route[j]) + matrix(route[i], route[j + 1])
+                  - matrix(route[i - 1], route[i]) - matrix(route[j], route[j + 1]);
+        if (!matrix.symmetric()) {
+            for (int k = i; k < j; k++) {
+                delta += matrix(route[k + 1], route[k]) - matrix(route[k], route[k + 1]);
+            }
+        }
+        return delta;
+    }
+
+    // Cost change of swapping route[i] and route[j] (i < j)
+    int swapDelta(const std::vector<int>& route, int i, int j) const {
+        int a = route[i - 1], b = route[i], c = route[j], d = route[j + 1];
+        if (j == i + 1) {
+            return matrix(a, c) + matrix(c, b) + matrix(b, d)
+                 - matrix(a, b) - matrix(b, c) - matrix(c, d);
+        }
+        int b2 = route[i + 1], c0 = route[j - 1];
+        return matrix(a, c) + matrix(c, b2) + matrix(c0, b) + matrix(b, d)
+             - matrix(a, b) - matrix(b, b2) - matrix(c0, c) - matrix(c, d);
+    }
+
+    void step(double temp) {
+        // Propose a move and price it
+        int moveType = randomIndex(3);
+        int routeIdx = randomIndex(numVehicles);
+        int destRouteIdx = 0, pos1 = 0, pos2 = 0;
+        int delta;
+
+        auto& route = currentSolution[routeIdx];
+        int customersInRoute = route.size() - 2;
+
+        if (moveType == 0) {
+            // Swap two nodes within the same route
+            if (customersInRoute < 2) {
+                return;
+            }
+            pos1 = 1 + randomIndex(customersInRoute);
+            pos2 = 1 + randomIndex(customersInRoute);
+            if (pos1 == pos2) {
+                return;
+            }
+            if (pos1 > pos2) std::swap(pos1, pos2);
+            delta = swapDelta(route, pos1, pos2);
+        }
+        else if (moveType == 1) {
+            // Move a node from one route to any position of another
+            destRouteIdx = randomIndex(numVehicles);
+            if (destRouteIdx == routeIdx || customersInRoute < 2) {
+                return;
+            }
+            const auto& dest = currentSolution[destRouteIdx];
+            pos1 = 1 + randomIndex(customersInRoute);
+            pos2 = 1 + randomIndex(dest.size() - 1); // Insert before dest[pos2]
+
+            int prev = route[pos1 - 1], node = route[pos1], next = route[pos1 + 1];
+            delta = matrix(prev, next) - matrix(prev, node) - matrix(node, next)
+                  + matrix(dest[pos2 - 1], node) + matrix(node, dest[pos2])
+                  - matrix(dest[pos2 - 1], dest[pos2]);
+        }
+        else {
+            // 2-opt: Reverse a segment within a route
+            if (customersInRoute < 2) {
+                return;
+            }
+            pos1 = 1 + randomIndex(customersInRoute);
+            pos2 = 1 + randomIndex(customersInRoute);
+            if (pos1 == pos2) {
+                return;
+            }
+            if (pos1 > pos2) std::swap(pos1, pos2);
+            delta = reversalDelta(route, pos1, pos2);
+        }
+
+        // Decide if we should accept the move
+        proposedMoves++;
+        if (delta >= 0 && realDist(gen) >= exp(-delta / temp)) {
+            return;
+        }
+        acceptedMoves++;
+
+        if (delta > 0) {
+            flushBest();
+        }
+
+        // Apply the move in place
+        if (moveType == 0) {
+            std::swap(route[pos1], route[pos2]);
+        } else if (moveType == 1) {
+            auto& dest = currentSolution[destRouteIdx];
+            int node = route[pos1];
+            route.erase(route.begin() + pos1);
+            dest.insert(dest.begin() + pos2, node);
+        } else {
+            std::reverse(route.begin() + pos1, route.begin() + pos2 + 1);
+        }
+        currentDistance += delta;
+
+        if (currentDistance < bestDistance) {
+            bestDistance = currentDistance;
+            bestPending = true;
+        }
+    }
+};
+
+// Simulated Annealing for VRP
+// With params.chains > 1 this runs parallel tempering: one chain per thread,
+// chain k at temp * spread^(k / (chains - 1)) as the shared schedule cools.
+// Every exchangeInterval cooling steps the threads meet at a barrier and
+// neighbouring chains swap states with the usual replica-exchange
+// probability min(1, exp((E_k - E_k+1) * (1/T_k - 1/T_k+1))).
+// With params.control the run stops early at its deadline or on cancellation
+// (checked every cooling step) and streams each new best as it is found.
+// With params.incumbent each chain checks the shared solution before every
+// epoch and continues from it when it beats the chain's best; the run is then
+// no longer reproducible from the seed alone.
+template <typename Matrix>
+std::vector<std::vector<int>> simulatedAnnealingVRP(const Matrix& matrix, int numVehicles,
+                                                    const AnnealingParams& params,
+                                                    AnnealingStats* stats = nullptr) {
+    unsigned seed = params.seed != 0 ? params.seed : unsigned(std::time(0));
+    int numChains = std::max(1, params.chains);
+    int interval = std::max(1, params.exchangeInterval);
+
+    Telemetry* telemetry = params.telemetry;
+    std::vector<AnnealingChain<Matrix>> chains;
+    chains.reserve(numChains);
+    timePhase(telemetry, "construct", [&] {
+        for (int k = 0; k < numChains; k++) {
+            chains.emplace_back(matrix, numVehicles, seed, k);
+        }
+    });
+
+    auto chainTemperature = [&](double temp, int k) {
+        if (numChains == 1) {
+            return temp;
+        }
+        return temp * std::pow(params.temperatureSpread, double(k) / (numChains - 1));
+    };
+
+    // Exchange decisions come from their own stream so they do not depend
+    // on which thread reaches the barrier last
+    std::mt19937 exchangeGen(seed ^ 0x9E3779B9u);
+    std::uniform_real_distribution<> realDist(0.0, 1.0);
+    long long exchangesAttempted = 0;
+    long long exchangesAccepted = 0;
+    int epoch = 0;
+    double temp = params.initialTemp;
+    bool stopping = false;
+
+    auto exchange = [&]() {
+        for (int s = 0; s < interval; s++) {
+            temp *= params.coolingRate;
+        }
+        for (int k = epoch % 2; k + 1 < numChains; k += 2) {
+            double beta1 = 1.0 / chainTemperature(temp, k);
+            double beta2 = 1.0 / chainTemperature(temp, k + 1);
+            double logRatio = (chains[k].distance() - chains[k + 1].distance()) * (beta1 - beta2);
+            exchangesAttempted++;
+            if (logRatio >= 0 || realDist(exchangeGen) < exp(logRatio)) {
+                chains[k].swapState(chains[k + 1]);
+                exchangesAccepted++;
+            }
+        }
+        epoch++;
+        // Decided here, where every chain is parked, so all of them leave together
+        stopping = stopRequested(params.control);
+    };
+
+    // Per-chain telemetry rows, merged in chain order after the run
+    std::vector<std::vector<TelemetryRow>> stepTrace(numChains), bestTrace(numChains);
+
+    // Every thread anneals its chain through one epoch of cooling steps from
+    // the shared temperature, then waits for the exchange
+    auto runChain = [&](int k, Barrier* barrier) {
+        int stepIndex = 0;
+        while (temp > params.minTemp && !stopping) {
+            if (params.incumbent != nullptr) {
+                chains[k].follow(*params.incumbent);
+            }
+            double chainTemp = temp;
+            for (int s = 0; s < interval && chainTemp > params.minTemp && !stopRequested(params.control); s++) {
+                long long proposedBefore = chains[k].proposed(), acceptedBefore = chains[k].accepted();
+                int bestBefore = chains[k].best();
+                chains[k].anneal(chainTemperature(chainTemp, k), params.iterationsPerTemp);
+                if (telemetry != nullptr) {
+                    long long proposed = chains[k].proposed() - proposedBefore;
+                    double acceptance = proposed > 0 ? double(chains[k].accepted() - acceptedBefore) / proposed : 0.0;
+                    stepTrace[k].push_back({{"chain", k}, {"step", stepIndex}, {"temperature", chainTemperature(chainTemp, k)},
+                                            {"acceptance", acceptance}, {"current", chains[k].distance()},
+                                            {"best", chains[k].best()}});
+                    if (chains[k].best() < bestBefore) {
+                        bestTrace[k].push_back({{"chain", k}, {"elapsed_ms", telemetry->elapsedMs()}, {"best", chains[k].best()}});
+                    }
+                }
+                if (params.control != nullptr && params.control->wantsImprovements() &&
+                    chains[k].best() < params.control->bestReported()) {
+                    params.control->reportImprovement(chains[k].bestRoutes(), chains[k].best());
+                }
+                stepIndex++;
+                chainTemp *= params.coolingRate;
+            }
+            if (barrier != nullptr) {
+                barrier->arriveAndWait(exchange);
+            } else {
+                exchange();
+            }
+        }
+    };
+
+    auto searchStart = std::chrono::steady_clock::now();
+    timePhase(telemetry, "search", [&] {
+        if (numChains == 1) {
+            runChain(0, nullptr);
+        } else {
+            Barrier barrier(numChains);
+            std::vector<std::thread> threads;
+            for (int k = 0; k < numChains; k++) {
+                threads.emplace_back(runChain, k, &barrier);
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+    });
+    std::chrono::duration<double> searchTime = std::chrono::steady_clock::now() - searchStart;
+
+    int bestChain = 0;
+    for (int k = 1; k < numChains; k++) {
+        if (chains[k].best() < chains[bestChain].best()) {
+            bestChain = k;
+        }
+    }
+
+    if (stats != nullptr) {
+        stats->iterations = 0;
+        for (const auto& chain : chains) {
+            stats->iterations += chain.iterations();
+        }
+        stats->exchangesAttempted = exchangesAttempted;
+        stats->exchangesAccepted = exchangesAccepted;
+    }
+
+    if (telemetry != nullptr) {
+        long long iterations = 0, proposed = 0, accepted = 0;
+        for (const auto& chain : chains) {
+            iterations += chain.iterations();
+            proposed += chain.proposed();
+            accepted += chain.accepted();
+        }
+        telemetry->setCounter("chains", numChains);
+        telemetry->setCounter("iterations", iterations);
+        telemetry->setCounter("iterations_per_sec", iterations / std::max(searchTime.count(), 1e-9));
+        telemetry->setCounter("acceptance_rate", proposed > 0 ? double(accepted) / proposed : 0.0);
+        telemetry->setCounter("exchanges_attempted", exchangesAttempted);
+        telemetry->setCounter("exchanges_accepted", exchangesAccepted);
+        telemetry->setCounter("best_distance", chains[bestChain].best());
+        for (int k = 0; k < numChains; k++) {
+            for (auto& row : stepTrace[k]) telemetry->addSample("temperature_steps", std::move(row));
+            for (auto& row : bestTrace[k]) telemetry->addSample("best_over_time", std::move(row));
+        }
+    }
+
+    return chains[bestChain].bestRoutes();
+}
+
+template <typename Matrix>
+std::vector<std::vector<int>> simulatedAnnealingVRP(const Matrix& matrix, int numVehicles) {
+    return simulatedAnnealingVRP(matrix, numVehicles, AnnealingParams());
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef SOLVERS_H
+#define SOLVERS_H
+
+#include "brute_force.h"
+#include "nearest_neighbor.h"
+#include "clarke_wright.h"
+#include "genetic_algorithm.h"
+#include "simulated_annealing.h"
+#include "portfolio.h"
+
+// Anytime variants honour the control's deadline and stream improvements;
+// with a deadline the GA keeps evolving until it expires. A seed of 0 seeds
+// from the clock
+template <typename Matrix>
+std::vector<std::vector<int>> geneticAlgorithmAnytime(const Matrix& matrix, int numVehicles,
+                                                      const SolveControl* control, unsigned seed) {
+    GeneticParams params;
+    params.control = control;
+    params.seed = seed;
+    if (control->hasDeadline()) {
+        params.generations = 0;
+    }
+    return geneticAlgorithmVRP(matrix, numVehicles, params);
+}
+
+template <typename Matrix>
+std::vector<std::vector<int>> simulatedAnnealingAnytime(const Matrix& matrix, int numVehicles,
+                                                        const SolveControl* control, unsigned seed) {
+    AnnealingParams params;
+    params.control = control;
+    params.seed = seed;
+    return simulatedAnnealingVRP(matrix, numVehicles, params);
+}
+
+// Constrained variants build routes that respect capacity and time windows
+template <typename Matrix>
+std::vector<std::vector<int>> nearestNeighborConstrained(const Matrix& matrix, int numVehicles,
+                                                         const Constraints* constraints) {
+    NearestNeighborParams params;
+    params.constraints = constraints;
+    return nearestNeighborVRP(matrix, numVehicles, params);
+}
+
+template <typename Matrix>
+std::vector<std::vector<int>> clarkeWrightConstrained(const Matrix& matrix, int numVehicles,
+                                                      const Constraints* constraints) {
+    ClarkeWrightParams params;
+    params.constraints = constraints;
+    return clarkeWrightVRP(matrix, numVehicles, params);
+}
+
+// Name -> solver lookup shared by the binaries that link every algorithm,
+// with one table per matrix cell type
+template <typename Matrix>
+struct SolverEntry {
+    using SolverFunction = std::vector<std::vector<int>> (*)(const Matrix&, int);
+    using AnytimeSolverFunction = std::vector<std::vector<int>> (*)(const Matrix&, int, const SolveControl*, unsigned);
+    using ConstrainedSolverFunction = std::vector<std::vector<int>> (*)(const Matrix&, int, const Constraints*);
+
+    const char* name;
+    SolverFunction solve;
+    AnytimeSolverFunction anytime;          // nullptr for solvers that finish in one pass
+    ConstrainedSolverFunction constrained;  // nullptr for solvers that ignore constraints
+};
+
+template <typename Matrix>
+const std::vector<SolverEntry<Matrix>>& solverRegistry() {
+    static const std::vector<SolverEntry<Matrix>> registry = {
+        {"brute_force", bruteForceVRP, nullptr, nullptr},
+        {"nearest_neighbor", nearestNeighborVRP, nullptr, nearestNeighborConstrained},
+        {"clarke_wright", clarkeWrightVRP, nullptr, clarkeWrightConstrained},
+        {"genetic_algorithm", geneticAlgorithmVRP, geneticAlgorithmAnytime, nullptr},
+        {"simulated_annealing", simulatedAnnealingVRP, simulatedAnnealingAnytime, nullptr},
+        {"portfolio", portfolioVRP, portfolioAnytime, portfolioConstrained},
+    };
+    return registry;
+}
+
+// Returns nullptr for unknown names
+template <typename Matrix = DistanceMatrix>
+const SolverEntry<Matrix>* findSolverEntry(const std::string& name) {
+    for (const auto& entry : solverRegistry<Matrix>()) {
+        if (name == entry.name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+template <typename Matrix = DistanceMatrix>
+typename SolverEntry<Matrix>::SolverFunction findSolver(const std::string& name) {
+    const SolverEntry<Matrix>* entry = findSolverEntry<Matrix>(name);
+    return entry != nullptr ? entry->solve : nullptr;
+}
+
+// Run one registry entry the way vrp_server and the Python module do: the
+// constrained variant when there are constraints, else the anytime variant
+template <typename Matrix>
+std::vector<std::vector<int>> runSolverEntry(const SolverEntry<Matrix>& entry, const Matrix& matrix, int numVehicles,
+                                             const Constraints* constraints, const SolveControl* control,
+                                             unsigned seed) {
+    if (constraints != nullptr && entry.constrained != nullptr) {
+        return entry.constrained(matrix, numVehicles, constraints);
+    }
+    if (entry.anytime != nullptr) {
+        return entry.anytime(matrix, numVehicles, control, seed);
+    }
+    return entry.solve(matrix, numVehicles);
+}
+
+#endif
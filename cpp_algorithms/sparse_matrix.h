@@ -0,0 +1,350 @@
+#ifndef SPARSE_MATRIX_H
+#define SPARSE_MATRIX_H
+
+#include "geo_matrix.h"
+#include <atomic>
+#include <cmath>
+
+// Static k-d tree over the delivery points 1..n of an embedded point set
+// (3 coordinates per node, node 0 being the depot), with a live count per
+// subtree: remove() takes a node out in O(log n) and the searches skip empty
+// subtrees, so "nearest node not yet visited" stays cheap to the end of a
+// construction. The tree shape is shared between copies; only the live
+// counts are copied, so a solver takes its own copy to remove nodes from.
+class SpatialIndex {
+public:
+    SpatialIndex() = default;
+
+    SpatialIndex(std::shared_ptr<const std::vector<double>> coordinates, int numCustomers)
+        : points(std::move(coordinates)) {
+        auto shape = std::make_shared<Shape>();
+        shape->order.resize(numCustomers);
+        shape->axis.assign(numCustomers, 0);
+        shape->position.assign(numCustomers + 1, -1);
+        for (int i = 0; i < numCustomers; i++) {
+            shape->order[i] = i + 1;
+        }
+        build(*shape, 0, numCustomers);
+        for (int i = 0; i < numCustomers; i++) {
+            shape->position[shape->order[i]] = i;
+        }
+        tree = std::move(shape);
+        live.assign(numCustomers, 0);
+        alive.assign(numCustomers, 1);
+        fill(0, numCustomers);
+    }
+
+    // Take a node out of later searches
+    void remove(int node) {
+        int target = tree->position[node];
+        if (target < 0 || !alive[target]) return;
+        alive[target] = 0;
+        int lo = 0, hi = int(tree->order.size());
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            live[mid]--;
+            if (mid == target) break;
+            if (target < mid) hi = mid; else lo = mid + 1;
+        }
+    }
+
+    // The k live nodes nearest to node `from` by (distance, node), nearest
+    // first, among those accept(node) allows; `from` itself is skipped.
+    // distance(node) is the exact distance from `from`, and reach(d) bounds
+    // the embedded distance of any node whose exact distance is at most d.
+    template <typename Distance, typename Reach, typename Accept>
+    void nearest(int from, int k, Distance distance, Reach reach, Accept accept,
+                 std::vector<std::pair<int, int>>& found) const {
+        found.clear();
+        double limit = std::numeric_limits<double>::infinity();
+        if (k > 0 && !tree->order.empty()) {
+            search(0, int(tree->order.size()), from, k, distance, reach, accept, found, limit);
+        }
+        std::sort_heap(found.begin(), found.end());
+    }
+
+private:
+    struct Shape {
+        std::vector<int> order;      // Nodes in tree order; a range's root is its middle
+        std::vector<uint8_t> axis;   // Split axis of each range root
+        std::vector<int> position;   // Index of each node in order
+    };
+
+    std::shared_ptr<const std::vector<double>> points;
+    std::shared_ptr<const Shape> tree;
+    std::vector<int> live;           // Live nodes in the range rooted at each index
+    std::vector<char> alive;
+
+    double coordinate(int node, int axis) const { return (*points)[size_t(node) * 3 + axis]; }
+
+    double separation(int a, int b) const {
+        double dx = coordinate(a, 0) - coordinate(b, 0);
+        double dy = coordinate(a, 1) - coordinate(b, 1);
+        double dz = coordinate(a, 2) - coordinate(b, 2);
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    // Split on the widest axis at the median
+    void build(Shape& shape, int lo, int hi) {
+        if (hi - lo <= 1) return;
+        double low[3], high[3];
+        for (int a = 0; a < 3; a++) {
+            low[a] = high[a] = coordinate(shape.order[lo], a);
+        }
+        for (int i = lo + 1; i < hi; i++) {
+            for (int a = 0; a < 3; a++) {
+                low[a] = std::min(low[a], coordinate(shape.order[i], a));
+                high[a] = std::max(high[a], coordinate(shape.order[i], a));
+            }
+        }
+        int axis = 0;
+        for (int a = 1; a < 3; a++) {
+            if (high[a] - low[a] > high[axis] - low[axis]) axis = a;
+        }
+        int mid = (lo + hi) / 2;
+        std::nth_element(shape.order.begin() + lo, shape.order.begin() + mid, shape.order.begin() + hi,
+                         [&](int a, int b) { return coordinate(a, axis) < coordinate(b, axis); });
+        shape.axis[mid] = axis;
+        build(shape, lo, mid);
+        build(shape, mid + 1, hi);
+    }
+
+    int fill(int lo, int hi) {
+        if (lo >= hi) return 0;
+        int mid = (lo + hi) / 2;
+        live[mid] = 1 + fill(lo, mid) + fill(mid + 1, hi);
+        return live[mid];
+    }
+
+    // found is a max-heap on (distance, node) holding at most k entries;
+    // once it is full, limit is the reach of its farthest entry
+    template <typename Distance, typename Reach, typename Accept>
+    void search(int lo, int hi, int from, int k, Distance& distance, Reach& reach, Accept& accept,
+                std::vector<std::pair<int, int>>& found, double& limit) const {
+        if (lo >= hi) return;
+        int mid = (lo + hi) / 2;
+        if (live[mid] == 0) return;
+        int node = tree->order[mid];
+        // The embedded distance rules most points out before the exact one is computed
+        if (alive[mid] && node != from && separation(from, node) <= limit && accept(node)) {
+            std::pair<int, int> candidate(distance(node), node);
+            if (int(found.size()) < k) {
+                found.push_back(candidate);
+                std::push_heap(found.begin(), found.end());
+            } else if (candidate < found.front()) {
+                std::pop_heap(found.begin(), found.end());
+                found.back() = candidate;
+                std::push_heap(found.begin(), found.end());
+            }
+            if (int(found.size()) == k) {
+                limit = reach(found.front().first);
+            }
+        }
+        int axis = tree->axis[mid];
+        double offset = coordinate(from, axis) - coordinate(node, axis);
+        bool leftFirst = offset < 0;
+        if (leftFirst) search(lo, mid, from, k, distance, reach, accept, found, limit);
+        else search(mid + 1, hi, from, k, distance, reach, accept, found, limit);
+        if (std::abs(offset) <= limit) {
+            if (leftFirst) search(mid + 1, hi, from, k, distance, reach, accept, found, limit);
+            else search(lo, mid, from, k, distance, reach, accept, found, limit);
+        }
+    }
+};
+
+// Tuning knobs for SparseDistanceMatrix
+struct SparseParams {
+    int neighbors = 32;                    // Exact distances kept per node
+    std::string metric = "haversine";      // "haversine" or "equirectangular" (see geo_matrix.h)
+    int threads = 1;                       // Threads used to build the lists
+    int cacheSets = 4096;                  // Per-thread cache of other pairs (2 entries per set)
+};
+
+// Distance provider for instances too large for a dense matrix
+// Keeps each node's k nearest delivery points with their exact distances,
+// ordered by (distance, node) exactly like NeighborLists, plus the points
+// themselves; any other pair is computed from the coordinates on demand and
+// remembered in a small per-thread LRU cache (2-way set associative, so
+// lookups need no locks). Memory is O(N k) instead of O(N^2): 100k stops at
+// k = 32 take about 30 MB. d(i, j) has the same values as haversineMatrix
+// or equirectangularMatrix, so solvers give the same routes as on the dense
+// matrix. Solvers that scan matrix rows use the spatial index instead
+// (SPARSE is true), and copies share all storage.
+class SparseDistanceMatrix {
+public:
+    static constexpr bool SPARSE = true;
+
+    SparseDistanceMatrix(const std::vector<GeoPoint>& points, const SparseParams& params)
+        : n(int(points.size()) - 1), metric(params.metric), cacheSets(std::max(1, params.cacheSets)) {
+        if (metric != "haversine" && metric != "equirectangular") {
+            throw std::runtime_error("Unknown sparse metric: " + metric);
+        }
+        if (n < 1 || n >= (1 << 21)) {
+            throw std::runtime_error("Sparse matrix supports 1 to 2097151 delivery points");
+        }
+        static std::atomic<uint64_t> instances{0};
+        owner = ++instances;
+
+        // Unit vectors for haversine (chords order pairs like arcs), plane
+        // coordinates in meters for equirectangular
+        const double DEGREES = 3.14159265358979323846 / 180.0;
+        auto coordinates = std::make_shared<std::vector<double>>(size_t(size()) * 3, 0.0);
+        double meanLat = 0.0;
+        for (const auto& point : points) {
+            meanLat += point.lat;
+        }
+        double scale = std::cos(meanLat / size() * DEGREES);
+        for (int i = 0; i < size(); i++) {
+            double* p = coordinates->data() + size_t(i) * 3;
+            double lat = points[i].lat * DEGREES, lon = points[i].lon * DEGREES;
+            if (metric == "haversine") {
+                p[0] = std::cos(lat) * std::cos(lon);
+                p[1] = std::cos(lat) * std::sin(lon);
+                p[2] = std::sin(lat);
+            } else {
+                p[0] = EARTH_RADIUS_METERS * points[i].lon * DEGREES * scale;
+                p[1] = EARTH_RADIUS_METERS * points[i].lat * DEGREES;
+            }
+        }
+        embedded = coordinates;
+        haversine = metric == "haversine";
+        spatial = SpatialIndex(coordinates, n);
+
+        width = std::max(0, std::min(params.neighbors, n - 1));
+        auto ids = std::make_shared<std::vector<int>>(size_t(size()) * width);
+        auto distances = std::make_shared<std::vector<int>>(size_t(size()) * width);
+        parallelFor(0, size(), params.threads, [&](int node) {
+            std::vector<std::pair<int, int>> found;
+            nearestIn(spatial, node, width, [](int) { return true; }, found);
+            for (int c = 0; c < width; c++) {
+                (*distances)[size_t(node) * width + c] = found[c].first;
+                (*ids)[size_t(node) * width + c] = found[c].second;
+            }
+        });
+        nearestIds = ids;
+        nearestDistances = distances;
+    }
+
+    // Number of delivery points (excluding the depot)
+    int customers() const { return n; }
+
+    // Number of nodes including the depot
+    int size() const { return n + 1; }
+
+    bool symmetric() const { return true; }
+
+    int scale() const { return 1; }
+
+    // Exact distances are kept for this many neighbours per node
+    int k() const { return width; }
+
+    // A node's nearest delivery points, nearest first
+    const int* nearest(int node) const { return nearestIds->data() + size_t(node) * width; }
+
+    int operator()(int from, int to) const {
+        if (from == to) return 0;
+        const int* ids = nearest(from);
+        for (int c = 0; c < width; c++) {
+            if (ids[c] == to) return (*nearestDistances)[size_t(from) * width + c];
+        }
+        return cached(from, to);
+    }
+
+    // The index over every delivery point; copy it to remove visited ones
+    const SpatialIndex& index() const { return spatial; }
+
+    // The count live nodes of alive nearest to `from` that accept allows,
+    // as (distance, node) pairs, nearest first
+    template <typename Accept>
+    void nearestIn(const SpatialIndex& alive, int from, int count, Accept accept,
+                   std::vector<std::pair<int, int>>& found) const {
+        auto distance = [&](int node) { return compute(from, node); };
+        auto reach = [&](int d) { return this->reach(d); };
+        alive.nearest(from, count, distance, reach, accept, found);
+    }
+
+    // Live node of alive nearest to `from` that accept allows, or -1
+    template <typename Accept>
+    int nearestIn(const SpatialIndex& alive, int from, Accept accept) const {
+        std::vector<std::pair<int, int>> found;
+        nearestIn(alive, from, 1, accept, found);
+        return found.empty() ? -1 : found[0].second;
+    }
+
+    int nearestIn(const SpatialIndex& alive, int from) const {
+        return nearestIn(alive, from, [](int) { return true; });
+    }
+
+private:
+    int n = 0;
+    std::string metric;
+    bool haversine = true;
+    int width = 0;
+    int cacheSets;
+    uint64_t owner = 0;
+    std::shared_ptr<const std::vector<double>> embedded;
+    std::shared_ptr<const std::vector<int>> nearestIds;
+    std::shared_ptr<const std::vector<int>> nearestDistances;
+    SpatialIndex spatial;
+
+    // The same arithmetic as haversineMatrix / equirectangularMatrix
+    int compute(int from, int to) const {
+        const double* a = embedded->data() + size_t(from) * 3;
+        const double* b = embedded->data() + size_t(to) * 3;
+        double dx = b[0] - a[0], dy = b[1] - a[1], dz = b[2] - a[2];
+        if (haversine) {
+            double half = std::min(0.5 * std::sqrt(dx * dx + dy * dy + dz * dz), 1.0);
+            return int(std::lround(2.0 * EARTH_RADIUS_METERS * std::asin(half)));
+        }
+        return int(std::sqrt(dx * dx + dy * dy) + 0.5);
+    }
+
+    // Largest embedded distance of a node whose rounded distance is d
+    double reach(int d) const {
+        double meters = d + 0.5;
+        if (haversine) {
+            return 2.0 * std::sin(std::min(meters / (2.0 * EARTH_RADIUS_METERS), 1.5707963267948966)) + 1e-12;
+        }
+        return meters + 1e-9;
+    }
+
+    int cached(int from, int to) const {
+        struct Entry {
+            uint64_t key = 0;
+            int distance = 0;
+        };
+        thread_local std::vector<Entry> entries;
+        thread_local std::vector<uint8_t> older;   // Which entry of each set to replace next
+        if (entries.size() != size_t(cacheSets) * 2) {
+            entries.assign(size_t(cacheSets) * 2, Entry());
+            older.assign(cacheSets, 0);
+        }
+        int a = std::min(from, to), b = std::max(from, to);
+        uint64_t key = owner << 42 | uint64_t(a) << 21 | uint64_t(b);
+        size_t set = size_t((key * 0x9E3779B97F4A7C15ull) >> 40) % cacheSets;
+        Entry* slot = &entries[set * 2];
+        for (int way = 0; way < 2; way++) {
+            if (slot[way].key == key) {
+                older[set] = 1 - way;
+                return slot[way].distance;
+            }
+        }
+        int way = older[set];
+        slot[way].key = key;
+        slot[way].distance = compute(a, b);
+        older[set] = 1 - way;
+        return slot[way].distance;
+    }
+};
+
+// The --sparse K [--metric haversine|equirectangular] [--threads T] options:
+// matrixFile is then a coordinates file ("lat lon" lines, depot first)
+inline SparseDistanceMatrix sparseMatrixFromCommandLine(const CommandLine& commandLine) {
+    SparseParams params;
+    params.neighbors = commandLine.getNumber("sparse", params.neighbors);
+    params.metric = commandLine.get("metric", params.metric);
+    params.threads = commandLine.getNumber("threads", params.threads);
+    return SparseDistanceMatrix(readCoordinates(commandLine.matrixFile), params);
+}
+
+#endif
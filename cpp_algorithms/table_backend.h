@@ -0,0 +1,398 @@
+#ifndef TABLE_BACKEND_H
+#define TABLE_BACKEND_H
+
+#include "geo_matrix.h"
+#include "json.h"
+#include "telemetry.h"
+#include "cache.h"
+#include <exception>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <netdb.h>
+#include <sys/socket.h>
+
+// Body of a 200 response to an HTTP/1.0 GET of a plain http:// URL.
+// HTTP/1.0 keeps the response unchunked and the server closes the
+// connection when it is done, so the body is everything after the headers.
+inline std::string httpGet(const std::string& url) {
+    const std::string scheme = "http://";
+    if (url.rfind(scheme, 0) != 0) {
+        throw std::runtime_error("Only http:// table URLs are supported: " + url);
+    }
+    size_t slash = url.find('/', scheme.size());
+    std::string authority = url.substr(scheme.size(), slash - scheme.size());
+    std::string path = slash == std::string::npos ? "/" : url.substr(slash);
+    size_t colon = authority.find(':');
+    std::string host = authority.substr(0, colon);
+    std::string port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+        throw std::runtime_error("Cannot resolve table host: " + host);
+    }
+    int fd = -1;
+    for (addrinfo* address = addresses; address != nullptr && fd < 0; address = address->ai_next) {
+        fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd >= 0 && connect(fd, address->ai_addr, address->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot connect to table service at " + authority);
+    }
+
+    std::string request = "GET " + path + " HTTP/1.0\r\nHost: " + host + "\r\nAccept: application/json\r\n\r\n";
+    const char* data = request.data();
+    size_t remaining = request.size();
+    while (remaining > 0) {
+        ssize_t written = write(fd, data, remaining);
+        if (written <= 0) {
+            close(fd);
+            throw std::runtime_error("Error sending request to " + authority);
+        }
+        data += written;
+        remaining -= written;
+    }
+    std::string response;
+    char buffer[1 << 16];
+    ssize_t bytesRead;
+    while ((bytesRead = read(fd, buffer, sizeof(buffer))) > 0) {
+        response.append(buffer, bytesRead);
+    }
+    close(fd);
+
+    size_t headerEnd = response.find("\r\n\r\n");
+    size_t space = response.find(' ');
+    if (headerEnd == std::string::npos || space == std::string::npos) {
+        throw std::runtime_error("Malformed HTTP response from " + authority);
+    }
+    int status = std::atoi(response.c_str() + space + 1);
+    if (status != 200) {
+        throw std::runtime_error("Table service returned HTTP " + std::to_string(status) + ": " +
+                                 response.substr(headerEnd + 4, 200));
+    }
+    return response.substr(headerEnd + 4);
+}
+
+// Tuning knobs for osrmTableMatrix
+struct TableParams {
+    std::string url = "http://127.0.0.1:5000";  // OSRM-compatible server
+    std::string profile = "driving";
+    int batch = 100;    // Most coordinates per request (the public OSRM server allows 100)
+    int threads = 8;    // Requests in flight
+    Telemetry* telemetry = nullptr;  // Request and reuse counters
+};
+
+// Fill matrix(s, t) for every s in sources and t in targets from an
+// OSRM-style /table service, in meters floored to whole meters
+// Both lists are cut into blocks of batch/2 nodes and every pair of blocks is
+// one request, so no request exceeds the server's coordinate limit; a block
+// paired with itself sends its coordinates once. Blocks are fetched
+// concurrently. Returns the number of requests made.
+inline int fetchTable(const std::vector<GeoPoint>& points, const std::vector<int>& sources,
+                      const std::vector<int>& targets, const TableParams& params, DistanceMatrix& matrix) {
+    int block = std::max(1, params.batch / 2);
+    int sourceBlocks = (int(sources.size()) + block - 1) / block;
+    int targetBlocks = (int(targets.size()) + block - 1) / block;
+    bool square = &sources == &targets || sources == targets;
+
+    auto coordinate = [&](int node) {
+        char text[64];
+        std::snprintf(text, sizeof(text), "%.6f,%.6f", points[node].lon, points[node].lat);
+        return std::string(text);
+    };
+
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+    parallelFor(0, sourceBlocks * targetBlocks, params.threads, [&](int job) {
+        try {
+            int sourceBegin = job / targetBlocks * block, targetBegin = job % targetBlocks * block;
+            int sourceCount = std::min(block, int(sources.size()) - sourceBegin);
+            int targetCount = std::min(block, int(targets.size()) - targetBegin);
+            bool diagonal = square && sourceBegin == targetBegin;
+
+            std::string coordinates, sourceList, destinationList;
+            for (int k = 0; k < sourceCount; k++) {
+                coordinates += (k > 0 ? ";" : "") + coordinate(sources[sourceBegin + k]);
+                sourceList += (k > 0 ? ";" : "") + std::to_string(k);
+            }
+            for (int k = 0; k < targetCount; k++) {
+                if (!diagonal) {
+                    coordinates += ";" + coordinate(targets[targetBegin + k]);
+                }
+                destinationList += (k > 0 ? ";" : "") + std::to_string(diagonal ? k : sourceCount + k);
+            }
+
+            JsonValue table = parseJson(httpGet(params.url + "/table/v1/" + params.profile + "/" + coordinates +
+                                                "?annotations=distance&sources=" + sourceList +
+                                                "&destinations=" + destinationList));
+            const JsonValue* code = table.find("code");
+            const JsonValue* distances = table.find("distances");
+            if (code == nullptr || code->string != "Ok" || distances == nullptr ||
+                int(distances->array.size()) != sourceCount) {
+                throw std::runtime_error("Table service error: " + (code != nullptr ? code->string : "no code"));
+            }
+            for (int s = 0; s < sourceCount; s++) {
+                const auto& row = distances->array[s].array;
+                if (int(row.size()) != targetCount) {
+                    throw std::runtime_error("Table service returned a short row");
+                }
+                for (int t = 0; t < targetCount; t++) {
+                    int from = sources[sourceBegin + s], to = targets[targetBegin + t];
+                    if (!row[t].isNumber()) {
+                        throw std::runtime_error("No route between nodes " + std::to_string(from) + " and " +
+                                                 std::to_string(to));
+                    }
+                    matrix.set(from, to, from == to ? 0 : int(row[t].number));
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            failure = std::current_exception();
+        }
+    });
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    return sourceBlocks * targetBlocks;
+}
+
+// Road distances in meters between every pair of points
+inline DistanceMatrix osrmTableMatrix(const std::vector<GeoPoint>& points, const TableParams& params) {
+    std::vector<int> all(points.size());
+    std::iota(all.begin(), all.end(), 0);
+    DistanceMatrix matrix(points.size() - 1);
+    int requests = fetchTable(points, all, all, params, matrix);
+    if (params.telemetry != nullptr) {
+        params.telemetry->setCounter("table_requests", requests);
+    }
+    matrix.setSymmetric(matrix.checkSymmetric());
+    return matrix;
+}
+
+// Cached table entry: the service it came from, the points and their matrix
+//   uint32 source length, source, int32 count, count x (lat, lon) doubles,
+//   count x count int32 distances
+struct TableEntry {
+    std::string source;
+    std::vector<GeoPoint> points;
+    size_t distanceOffset = 0;   // Where the distances start in the entry
+};
+
+// Parse an entry's header; false when the bytes are too short or malformed
+inline bool parseTableEntry(const std::string& bytes, TableEntry& entry) {
+    uint32_t length;
+    int32_t count;
+    if (bytes.size() < 4) return false;
+    std::memcpy(&length, bytes.data(), 4);
+    if (bytes.size() < 8 + size_t(length)) return false;
+    entry.source = bytes.substr(4, length);
+    std::memcpy(&count, bytes.data() + 4 + length, 4);
+    size_t pointOffset = 8 + size_t(length);
+    if (count < 0 || bytes.size() < pointOffset + 16 * size_t(count)) return false;
+    entry.points.resize(count);
+    std::memcpy(entry.points.data(), bytes.data() + pointOffset, 16 * size_t(count));
+    entry.distanceOffset = pointOffset + 16 * size_t(count);
+    return true;
+}
+
+// Points are matched at the 6 decimals sent to the service
+inline std::pair<int64_t, int64_t> pointKey(const GeoPoint& point) {
+    return {std::llround(point.lat * 1e6), std::llround(point.lon * 1e6)};
+}
+
+// osrmTableMatrix through a DiskCache
+// An identical point set (in any order) from the same service comes straight
+// from the cache. Otherwise the most recently used entries are searched for
+// the one sharing the most points; its distances are copied and only the
+// rows and columns of the new points are fetched, so resubmitting a stop set
+// with a few stops changed costs a few rows instead of the whole table.
+inline DistanceMatrix cachedTableMatrix(const std::vector<GeoPoint>& points, const TableParams& params,
+                                        const DiskCache& cache) {
+    const size_t CANDIDATES = 16;
+    int size = points.size();
+    std::string source = params.url + "/" + params.profile;
+
+    // Order-independent key: the sorted point set
+    std::vector<std::pair<int64_t, int64_t>> sorted;
+    for (const auto& point : points) {
+        sorted.push_back(pointKey(point));
+    }
+    std::sort(sorted.begin(), sorted.end());
+    ContentHash hash;
+    hash.add(source);
+    hash.add(sorted.data(), sorted.size() * sizeof(sorted[0]));
+    std::string key = "matrix-" + hash.hex() + ".bin";
+
+    std::map<std::pair<int64_t, int64_t>, int> wanted;
+    for (int i = 0; i < size; i++) {
+        wanted.emplace(pointKey(points[i]), i);
+    }
+
+    // Best donor: the exact entry if present, else the largest overlap
+    std::vector<std::string> candidates = cache.keys("matrix-");
+    if (std::find(candidates.begin(), candidates.end(), key) != candidates.end()) {
+        candidates = {key};
+    } else if (candidates.size() > CANDIDATES) {
+        candidates.resize(CANDIDATES);
+    }
+    std::string donorKey;
+    int donorOverlap = 1;
+    for (const auto& candidate : candidates) {
+        std::string header;
+        TableEntry entry;
+        if (!cache.peek(candidate, header, 1 << 16) || !parseTableEntry(header, entry)) {
+            if (!cache.peek(candidate, header) || !parseTableEntry(header, entry)) continue;
+        }
+        if (entry.source != source) continue;
+        int overlap = 0;
+        for (const auto& point : entry.points) {
+            overlap += wanted.count(pointKey(point));
+        }
+        if (overlap > donorOverlap) {
+            donorKey = candidate;
+            donorOverlap = overlap;
+        }
+    }
+
+    DistanceMatrix matrix(size - 1);
+    std::vector<int> known, fresh;
+    std::vector<int> donorIndex(size, -1);
+    std::string bytes;
+    TableEntry donor;
+    if (!donorKey.empty() && cache.load(donorKey, bytes) && parseTableEntry(bytes, donor) &&
+        bytes.size() == donor.distanceOffset + 4 * donor.points.size() * donor.points.size()) {
+        for (size_t k = 0; k < donor.points.size(); k++) {
+            auto found = wanted.find(pointKey(donor.points[k]));
+            if (found != wanted.end()) {
+                donorIndex[found->second] = k;
+            }
+        }
+    }
+    for (int i = 0; i < size; i++) {
+        (donorIndex[i] >= 0 ? known : fresh).push_back(i);
+    }
+    const int32_t* stored = reinterpret_cast<const int32_t*>(bytes.data() + donor.distanceOffset);
+    for (int i : known) {
+        int* row = matrix.row(i);
+        const int32_t* storedRow = stored + size_t(donorIndex[i]) * donor.points.size();
+        for (int j : known) {
+            row[j] = storedRow[donorIndex[j]];
+        }
+    }
+
+    int requests = 0;
+    if (!fresh.empty()) {
+        std::vector<int> all(size);
+        std::iota(all.begin(), all.end(), 0);
+        requests += fetchTable(points, fresh, all, params, matrix);
+        requests += fetchTable(points, known, fresh, params, matrix);
+
+        std::string entry;
+        uint32_t length = source.size();
+        int32_t count = size;
+        entry.append(reinterpret_cast<const char*>(&length), 4);
+        entry += source;
+        entry.append(reinterpret_cast<const char*>(&count), 4);
+        entry.append(reinterpret_cast<const char*>(points.data()), 16 * size_t(size));
+        for (int i = 0; i < size; i++) {
+            entry.append(reinterpret_cast<const char*>(matrix.row(i)), 4 * size_t(size));
+        }
+        cache.store(key, entry);
+    }
+    if (params.telemetry != nullptr) {
+        params.telemetry->setCounter("table_requests", requests);
+        params.telemetry->setCounter("cached_points", known.size());
+    }
+    matrix.setSymmetric(matrix.checkSymmetric());
+    return matrix;
+}
+
+// Recorded table: a stand-in for the road service, holding
+//   {"coordinates": [[lon, lat], ...], "distances": [[...], ...]}
+// in the same shape as an OSRM table response. Points are matched by
+// coordinate (to 6 decimals), so a recording can serve any subset of its points.
+inline DistanceMatrix recordedTableMatrix(const std::vector<GeoPoint>& points, const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening recorded table: " + filename);
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    JsonValue table = parseJson(contents.str());
+    const JsonValue* coordinates = table.find("coordinates");
+    const JsonValue* distances = table.find("distances");
+    if (coordinates == nullptr || distances == nullptr ||
+        coordinates->array.size() != distances->array.size()) {
+        throw std::runtime_error("Recorded table needs matching \"coordinates\" and \"distances\": " + filename);
+    }
+
+    auto key = [](double lon, double lat) {
+        char text[64];
+        std::snprintf(text, sizeof(text), "%.6f,%.6f", lon, lat);
+        return std::string(text);
+    };
+    std::map<std::string, int> recorded;
+    for (size_t i = 0; i < coordinates->array.size(); i++) {
+        const auto& pair = coordinates->array[i].array;
+        if (pair.size() != 2) {
+            throw std::runtime_error("Recorded coordinates must be [lon, lat] pairs: " + filename);
+        }
+        recorded[key(pair[0].number, pair[1].number)] = i;
+    }
+
+    int size = points.size();
+    std::vector<int> index(size);
+    for (int i = 0; i < size; i++) {
+        auto found = recorded.find(key(points[i].lon, points[i].lat));
+        if (found == recorded.end()) {
+            throw std::runtime_error("Recorded table has no entry for point " + std::to_string(i) + " (" +
+                                     key(points[i].lon, points[i].lat) + ")");
+        }
+        index[i] = found->second;
+    }
+
+    DistanceMatrix matrix(size - 1);
+    for (int i = 0; i < size; i++) {
+        const auto& row = distances->array[index[i]].array;
+        for (int j = 0; j < size; j++) {
+            if (size_t(index[j]) >= row.size() || !row[index[j]].isNumber()) {
+                throw std::runtime_error("Recorded table has no distance for points " + std::to_string(i) +
+                                         " -> " + std::to_string(j));
+            }
+            matrix.set(i, j, i == j ? 0 : int(row[index[j]].number));
+        }
+    }
+    matrix.setSymmetric(matrix.checkSymmetric());
+    return matrix;
+}
+
+// Save a matrix as a recorded table that recordedTableMatrix can replay
+inline void writeRecordedTable(const std::vector<GeoPoint>& points, const DistanceMatrix& matrix,
+                               const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening output file: " + filename);
+    }
+    file << "{\"coordinates\":[";
+    for (size_t i = 0; i < points.size(); i++) {
+        file << (i > 0 ? "," : "") << "[" << jsonNumber(points[i].lon) << "," << jsonNumber(points[i].lat) << "]";
+    }
+    file << "],\n\"distances\":[";
+    for (int i = 0; i < matrix.size(); i++) {
+        file << (i > 0 ? ",\n" : "") << "[";
+        for (int j = 0; j < matrix.size(); j++) {
+            file << (j > 0 ? "," : "") << matrix(i, j);
+        }
+        file << "]";
+    }
+    file << "]}\n";
+}
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "common.h"
+#include "json.h"
+#include <chrono>
+#include <mutex>
+
+// One row of a trace series: named numeric fields in a fixed order
+using TelemetryRow = std::vector<std::pair<std::string, double>>;
+
+// Opt-in solver instrumentation
+// Solvers receive a Telemetry* through their params and record into it only
+// when it is non-null, so a run without telemetry pays one pointer test per
+// phase or cooling step and nothing per iteration. Phases accumulate wall
+// time, counters hold scalars and trace series hold one row per step.
+// Recording is thread-safe; the report is written once at the end.
+class Telemetry {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Telemetry() : start(Clock::now()) {}
+
+    // Milliseconds since the telemetry was created
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void addPhase(const std::string& name, double ms) {
+        std::lock_guard<std::mutex> lock(mutex);
+        slot(phases, name + "_ms") += ms;
+    }
+
+    void setCounter(const std::string& name, double value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        slot(counters, name) = value;
+    }
+
+    void addSample(const std::string& series, TelemetryRow row) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& entry : traces) {
+            if (entry.first == series) {
+                entry.second.push_back(std::move(row));
+                return;
+            }
+        }
+        traces.emplace_back(series, std::vector<TelemetryRow>{std::move(row)});
+    }
+
+    std::string toJson() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto object = [](const TelemetryRow& fields) {
+            std::string result = "{";
+            for (size_t i = 0; i < fields.size(); i++) {
+                if (i > 0) result += ",";
+                result += jsonQuote(fields[i].first) + ":" + jsonNumber(fields[i].second);
+            }
+            return result + "}";
+        };
+        std::string result = "{\"phases\":" + object(phases) + ",\"counters\":" + object(counters) + ",\"trace\":{";
+        for (size_t s = 0; s < traces.size(); s++) {
+            if (s > 0) result += ",";
+            result += jsonQuote(traces[s].first) + ":[";
+            for (size_t i = 0; i < traces[s].second.size(); i++) {
+                if (i > 0) result += ",";
+                result += object(traces[s].second[i]);
+            }
+            result += "]";
+        }
+        return result + "}}";
+    }
+
+private:
+    Clock::time_point start;
+    mutable std::mutex mutex;
+    TelemetryRow phases;
+    TelemetryRow counters;
+    std::vector<std::pair<std::string, std::vector<TelemetryRow>>> traces;
+
+    static double& slot(TelemetryRow& fields, const std::string& name) {
+        for (auto& field : fields) {
+            if (field.first == name) return field.second;
+        }
+        fields.emplace_back(name, 0.0);
+        return fields.back().second;
+    }
+};
+
+// Run body() and, when telemetry is on, add its wall time to a phase
+template <typename Body>
+auto timePhase(Telemetry* telemetry, const char* phase, Body body) -> decltype(body()) {
+    if (telemetry == nullptr) {
+        return body();
+    }
+    auto begin = Telemetry::Clock::now();
+    struct Record {
+        Telemetry* telemetry;
+        const char* phase;
+        Telemetry::Clock::time_point begin;
+        ~Record() {
+            telemetry->addPhase(phase, std::chrono::duration<double, std::milli>(Telemetry::Clock::now() - begin).count());
+        }
+    } record{telemetry, phase, begin};
+    return body();
+}
+
+// The --telemetry[=FILE] option: nullptr when absent
+inline Telemetry* telemetryFromCommandLine(const CommandLine& commandLine, Telemetry& telemetry) {
+    return commandLine.has("telemetry") ? &telemetry : nullptr;
+}
+
+// Write the report to the --telemetry file, or to stderr when no file is given
+template <typename Matrix>
+void writeTelemetry(const CommandLine& commandLine, const Telemetry* telemetry, const std::string& solver,
+                    const Matrix& matrix) {
+    if (telemetry == nullptr) {
+        return;
+    }
+    std::string report = "{\"solver\":" + jsonQuote(solver) + ",\"customers\":" + std::to_string(matrix.customers()) +
+                         ",\"vehicles\":" + std::to_string(commandLine.numVehicles) + "," + telemetry->toJson().substr(1);
+    std::string path = commandLine.get("telemetry");
+    if (path.empty()) {
+        std::cerr << report << std::endl;
+        return;
+    }
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening telemetry file: " + path);
+    }
+    file << report << std::endl;
+}
+
+#endif
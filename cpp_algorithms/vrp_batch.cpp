@@ -0,0 +1,267 @@
+#include "solvers.h"
+#include "local_search.h"
+#include "instances.h"
+#include "json.h"
+#include <chrono>
+
+// Usage: vrp_batch --manifest FILE [--algorithm NAME] [--vehicles K] [--local-search]
+//          [--time-limit SECONDS] [--seed S] [--threads T]
+//          [--distance-type auto|int32|uint16] [--output FILE]
+//
+// Solves many independent instances in one process. The manifest has one
+// instance per line, "PATH [key=value ...]"; blank lines and # comments are
+// skipped. PATH is a matrix file (text or binary, as for the solvers) or a
+// TSPLIB/CVRPLIB .tsp/.vrp file, whose capacity and demands are enforced.
+// The keys override the command line for that instance: vehicles, algorithm,
+// constraints (a --constraints file), local_search (0/1), time_limit, seed.
+//
+// Instances are ordered by node count, largest first, and dealt to a work
+// stealing pool (workStealingFor), so a worker that finishes its share takes
+// over queued instances from the others instead of idling behind one large
+// instance. Each instance is solved single-threaded.
+//
+// Output (stdout or --output): one JSON line per instance, in the order they finish:
+//   {"instance": 3, "name": "north.bin", "nodes": 120, "algorithm": "clarke_wright",
+//    "worker": 1, "start_ms": 40.2, "load_ms": 1.5, "solve_ms": 15.3,
+//    "distance": 1234, "routes": [[0, 5, 2, 0], ...]}
+// "instance" is the manifest line's position among the instances (from 0),
+// "start_ms" is when the instance was picked up, from the start of the batch.
+// A failed instance gives {"instance": 3, "name": ..., "error": "..."}; the
+// batch continues, and the exit status is 1 if any instance failed. A summary
+// with the wall time and worker utilization goes to stderr.
+
+struct BatchJob {
+    std::string path;
+    int numVehicles = 0;          // 0 = the instance file's, else --vehicles
+    std::string algorithm;
+    std::string constraintsFile;
+    bool improve = false;
+    double timeLimit = 0.0;       // Seconds; 0 = none
+    unsigned seed = 0;
+    int nodes = 0;                // Estimated from the file header, for ordering
+};
+
+bool isTsplibFile(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    std::string extension = dot == std::string::npos ? "" : path.substr(dot);
+    return extension == ".vrp" || extension == ".tsp";
+}
+
+// Node count from the start of the file: the binary header, a text
+// matrix's count line or a TSPLIB DIMENSION entry; 0 when unknown (a
+// missing file is reported when the instance runs)
+int estimateNodes(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    MatrixFileHeader header;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+        std::memcmp(header.magic, MATRIX_FILE_MAGIC, 4) == 0) {
+        return int(header.customers) + 1;
+    }
+    file.clear();
+    file.seekg(0);
+    std::string line;
+    for (int lines = 0; lines < 64 && std::getline(file, line); lines++) {
+        if (isTsplibFile(path)) {
+            if (line.find("DIMENSION") != std::string::npos) {
+                size_t colon = line.find(':');
+                return std::atoi(line.c_str() + (colon == std::string::npos ? line.find("DIMENSION") + 9 : colon + 1));
+            }
+        } else if (line.find_first_not_of(" \t\r") != std::string::npos) {
+            return std::atoi(line.c_str()) + 1;
+        }
+    }
+    return 0;
+}
+
+std::vector<BatchJob> readManifest(const std::string& filename, const CommandLine& commandLine) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening manifest: " + filename);
+    }
+    BatchJob defaults;
+    defaults.numVehicles = commandLine.getNumber("vehicles", 0);
+    defaults.algorithm = commandLine.get("algorithm", "clarke_wright");
+    defaults.improve = commandLine.has("local-search");
+    defaults.timeLimit = commandLine.getNumber("time-limit", 0.0);
+    defaults.seed = commandLine.getNumber("seed", 0);
+
+    std::vector<BatchJob> jobs;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream fields(line.substr(0, line.find('#')));
+        BatchJob job = defaults;
+        if (!(fields >> job.path)) {
+            continue;
+        }
+        std::string field;
+        while (fields >> field) {
+            size_t equals = field.find('=');
+            std::string key = field.substr(0, equals);
+            std::string value = equals == std::string::npos ? "" : field.substr(equals + 1);
+            if (key == "vehicles") {
+                job.numVehicles = std::atoi(value.c_str());
+            } else if (key == "algorithm") {
+                job.algorithm = value;
+            } else if (key == "constraints") {
+                job.constraintsFile = value;
+            } else if (key == "local_search") {
+                job.improve = value != "0";
+            } else if (key == "time_limit") {
+                job.timeLimit = std::atof(value.c_str());
+            } else if (key == "seed") {
+                job.seed = std::strtoul(value.c_str(), nullptr, 10);
+            } else {
+                throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": unknown key " + key);
+            }
+        }
+        if (findSolverEntry(job.algorithm) == nullptr) {
+            throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": unknown algorithm " +
+                                     job.algorithm);
+        }
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Load and solve one instance; returns the JSON fields after "name"
+std::string solveJob(const BatchJob& job, const std::string& distanceType) {
+    auto start = std::chrono::steady_clock::now();
+    DistanceMatrix priced;        // Original distances when the solve runs on a converted copy
+    bool repriced = false;
+    Constraints constraints;
+    int numVehicles = job.numVehicles;
+    LoadedMatrix stored;
+    if (isTsplibFile(job.path)) {
+        Instance instance = loadTsplibInstance(job.path);
+        constraints.demands = instance.demands;
+        constraints.capacity = instance.capacity;
+        if (numVehicles < 1) {
+            numVehicles = instance.vehicles;
+        }
+        priced = std::move(instance.matrix);
+        stored = chooseDistanceType(priced, distanceType);
+        repriced = true;
+    } else if (distanceType == "uint16") {
+        // Quantized solves are still priced on the original distances
+        priced = readDistanceMatrix(job.path);
+        stored = chooseDistanceType(priced, distanceType);
+        repriced = true;
+    } else {
+        stored = loadDistanceMatrix(job.path, distanceType);
+    }
+    if (numVehicles < 1) {
+        numVehicles = 2;
+    }
+    if (!job.constraintsFile.empty()) {
+        constraints = stored.visit([&](const auto& matrix) { return readConstraints(job.constraintsFile, matrix); });
+    }
+    stored.visit([&](const auto& matrix) { constraints.validate(matrix); });
+    const Constraints* limits = constraints.active() ? &constraints : nullptr;
+    double loadMs = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    SolveControl control;
+    if (job.timeLimit > 0.0) {
+        control.setTimeLimit(job.timeLimit);
+    }
+    auto routes = stored.visit([&](const auto& matrix) {
+        using Matrix = std::decay_t<decltype(matrix)>;
+        std::vector<std::vector<int>> found =
+            runSolverEntry(*findSolverEntry<Matrix>(job.algorithm), matrix, numVehicles, limits, &control, job.seed);
+        if (job.improve) {
+            LocalSearchParams search;
+            search.control = &control;
+            search.constraints = limits;
+            found = localSearchVRP(matrix, found, search);
+        }
+        return found;
+    });
+    double solveMs = millisecondsSince(start);
+
+    int nodes = stored.visit([](const auto& matrix) { return matrix.size(); });
+    int distance = repriced ? calculateTotalDistance(routes, priced)
+                            : stored.visit([&](const auto& matrix) { return calculateTotalDistance(routes, matrix); });
+    std::string fields = ",\"nodes\":" + std::to_string(nodes) + ",\"algorithm\":" +
+                         jsonQuote(job.algorithm + (job.improve ? "+ls" : "")) +
+                         ",\"load_ms\":" + std::to_string(loadMs) + ",\"solve_ms\":" + std::to_string(solveMs) +
+                         ",\"distance\":" + std::to_string(distance);
+    if (limits != nullptr) {
+        fields += ",\"violation\":" +
+                  std::to_string(stored.visit([&](const auto& matrix) { return limits->violation(routes, matrix); }));
+    }
+    return fields + ",\"routes\":" + routesToJson(routes);
+}
+
+int main(int argc, char** argv) try {
+    CommandLine commandLine = parseCommandLine(argc, argv);
+    if (commandLine.get("manifest").empty()) {
+        std::cerr << "Usage: " << argv[0] << " --manifest FILE [--algorithm NAME] [--vehicles K] [--local-search]"
+                  << " [--time-limit SECONDS] [--seed S] [--threads T]"
+                  << " [--distance-type auto|int32|uint16] [--output FILE]" << std::endl;
+        return 1;
+    }
+    std::string distanceType = commandLine.get("distance-type", "auto");
+    int numThreads = commandLine.getNumber("threads", std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<BatchJob> jobs = readManifest(commandLine.get("manifest"), commandLine);
+
+    std::ofstream outputFile;
+    if (commandLine.has("output")) {
+        outputFile.open(commandLine.get("output"));
+        if (!outputFile.is_open()) {
+            throw std::runtime_error("Error opening output file: " + commandLine.get("output"));
+        }
+    }
+    std::ostream& out = outputFile.is_open() ? outputFile : std::cout;
+
+    // Largest first, so the long solves start while there is work to balance them
+    std::vector<int> order(jobs.size());
+    for (size_t k = 0; k < jobs.size(); k++) {
+        jobs[k].nodes = estimateNodes(jobs[k].path);
+        order[k] = int(k);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return jobs[a].nodes > jobs[b].nodes; });
+
+    auto batchStart = std::chrono::steady_clock::now();
+    std::mutex outputMutex;
+    std::vector<double> busyMs(std::max(1, numThreads), 0.0);
+    int failures = 0;
+    workStealingFor(order, numThreads, [&](int k, int worker) {
+        double startMs = millisecondsSince(batchStart);
+        std::string fields;
+        bool failed = false;
+        try {
+            fields = solveJob(jobs[k], distanceType);
+        } catch (const std::exception& e) {
+            fields = ",\"error\":" + jsonQuote(e.what());
+            failed = true;
+        }
+        double endMs = millisecondsSince(batchStart);
+        std::string line = "{\"instance\":" + std::to_string(k) + ",\"name\":" + jsonQuote(jobs[k].path) +
+                           ",\"worker\":" + std::to_string(worker) + ",\"start_ms\":" + std::to_string(startMs) +
+                           fields + "}";
+        std::lock_guard<std::mutex> lock(outputMutex);
+        out << line << std::endl;
+        busyMs[worker] += endMs - startMs;
+        failures += failed;
+    });
+
+    double wallMs = millisecondsSince(batchStart);
+    double totalBusyMs = 0.0;
+    for (double ms : busyMs) {
+        totalBusyMs += ms;
+    }
+    int workers = std::max(1, std::min<int>(numThreads, jobs.size()));
+    std::cerr << jobs.size() << " instances (" << failures << " failed) in " << wallMs << " ms on " << workers
+              << " worker(s), " << int(wallMs > 0 ? 100.0 * totalBusyMs / (wallMs * workers) : 100.0)
+              << "% utilization" << std::endl;
+    return failures > 0 ? 1 : 0;
+} catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+}
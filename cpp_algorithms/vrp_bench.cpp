@@ -0,0 +1,340 @@
+#include "solvers.h"
+#include "local_search.h"
+#include "instances.h"
+#include "json.h"
+#include <chrono>
+#include <csignal>
+#include <map>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// Usage: vrp_bench [--instances a.vrp,b.tsp] [--synthetic 100,1000,...]
+//          [--algorithms nearest_neighbor,clarke_wright+ls,...] [--vehicles K]
+//          [--seed S] [--budget SECONDS] [--max-matrix-mb MB] [--threads T]
+//          [--distance-type auto|int32|uint16]
+//          [--format csv|json] [--output FILE] [--compare previous.csv] [--tolerance 0.10]
+//
+// Benchmarks every algorithm on every instance. Each run is forked into its
+// own process, which gives a clean peak RSS per run and lets the budget be
+// enforced with a timer that kills the run. SA, the GA and the local search
+// stop shortly before it and report their best cost as a "timeout" row; a
+// run the timer kills has no cost. Results go to stdout (or
+// --output) as CSV or JSON; --compare reads an earlier CSV and reports runs
+// that got slower or worse, exiting with status 2 if there are any.
+// CVRPLIB capacities are enforced by the solvers that support constraints
+// and by "+ls"; runs that still exceed them say so in the message column.
+// Solvers run on the matrix stored as --distance-type; costs are always
+// priced on the original int32 matrix.
+
+const char* DEFAULT_ALGORITHMS = "brute_force,nearest_neighbor,clarke_wright,genetic_algorithm,simulated_annealing";
+const char* DEFAULT_SIZES = "100,200,500,1000,2000,5000,10000,20000,50000";
+// Share of --budget after which the anytime solvers stop; the rest is left
+// for pricing and reporting the routes before the alarm
+const double BUDGET_STOP_FRACTION = 0.9;
+
+struct BenchResult {
+    std::string instance;
+    int nodes = 0;
+    std::string algorithm;
+    unsigned seed = 0;
+    std::string status;          // "ok", "timeout", "skipped" or "error"
+    double runtimeMs = 0.0;
+    long peakRssKb = 0;
+    long long cost = -1;
+    long long bestKnown = -1;
+    std::string message;
+};
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+// Solve with a fixed seed; a "+ls" suffix chains the local search stage
+// SA, the GA and the local search stop at the control's deadline with their
+// best solution so far; the GA keeps its fixed generation count otherwise
+template <typename Matrix>
+std::vector<std::vector<int>> runAlgorithm(const std::string& name, const Matrix& matrix, int numVehicles,
+                                           unsigned seed, const Constraints* constraints,
+                                           const SolveControl* control) {
+    bool improve = name.size() > 3 && name.compare(name.size() - 3, 3, "+ls") == 0;
+    std::string base = improve ? name.substr(0, name.size() - 3) : name;
+
+    std::vector<std::vector<int>> routes;
+    const SolverEntry<Matrix>* entry = findSolverEntry<Matrix>(base);
+    if (constraints != nullptr && entry != nullptr && entry->constrained != nullptr) {
+        routes = entry->constrained(matrix, numVehicles, constraints);
+    } else if (base == "genetic_algorithm") {
+        GeneticParams params;
+        params.seed = seed;
+        params.control = control;
+        routes = geneticAlgorithmVRP(matrix, numVehicles, params);
+    } else if (base == "simulated_annealing") {
+        AnnealingParams params;
+        params.seed = seed;
+        params.control = control;
+        routes = simulatedAnnealingVRP(matrix, numVehicles, params);
+    } else if (entry != nullptr && entry->anytime != nullptr) {
+        routes = entry->anytime(matrix, numVehicles, control, seed);
+    } else if (entry != nullptr) {
+        routes = entry->solve(matrix, numVehicles);
+    } else {
+        throw std::runtime_error("unknown algorithm: " + base);
+    }
+    if (improve) {
+        LocalSearchParams params;
+        params.constraints = constraints;
+        params.control = control;
+        routes = localSearchVRP(matrix, routes, params);
+    }
+    return routes;
+}
+
+// Run one algorithm in a child process under a wall-clock budget
+BenchResult benchmark(const Instance& instance, const std::string& algorithm, int numVehicles,
+                      unsigned seed, int budgetSeconds, const std::string& distanceType) {
+    BenchResult result;
+    result.instance = instance.name;
+    result.nodes = instance.matrix.customers();
+    result.algorithm = algorithm;
+    result.seed = seed;
+    result.bestKnown = instance.bestKnown;
+
+    if (algorithm.rfind("brute_force", 0) == 0 && result.nodes > EXACT_MAX_CUSTOMERS) {
+        result.status = "skipped";
+        result.message = "exact solver limit";
+        return result;
+    }
+
+    int channel[2];
+    if (pipe(channel) != 0) {
+        throw std::runtime_error("pipe failed");
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error("fork failed");
+    }
+    if (pid == 0) {
+        close(channel[0]);
+        alarm(budgetSeconds);
+        // The anytime solvers wind down before the alarm, so a run over
+        // budget still reports the cost it reached
+        SolveControl control;
+        control.setTimeLimit(budgetSeconds * BUDGET_STOP_FRACTION);
+        std::string report;
+        try {
+            Constraints constraints;
+            constraints.demands = instance.demands;
+            constraints.capacity = instance.capacity;
+            const Constraints* limits = constraints.active() ? &constraints : nullptr;
+            LoadedMatrix stored = chooseDistanceType(instance.matrix, distanceType);
+            auto start = std::chrono::steady_clock::now();
+            auto routes = stored.visit([&](const auto& matrix) {
+                return runAlgorithm(algorithm, matrix, numVehicles, seed, limits, &control);
+            });
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            report = std::string(control.stopRequested() ? "timeout " : "ok ") + std::to_string(elapsed.count()) +
+                     " " + std::to_string(calculateTotalDistance(routes, instance.matrix));
+            if (control.stopRequested()) {
+                report += " best so far at the budget";
+            }
+            if (limits != nullptr && limits->violation(routes, instance.matrix) > 0) {
+                report += std::string(control.stopRequested() ? "," : "") + " capacity exceeded by " +
+                          std::to_string(limits->violation(routes, instance.matrix));
+            }
+        } catch (const std::exception& e) {
+            report = std::string("error 0 -1 ") + e.what();
+        }
+        ssize_t written = write(channel[1], report.data(), report.size());
+        _exit(written == ssize_t(report.size()) ? 0 : 1);
+    }
+
+    close(channel[1]);
+    std::string report;
+    char buffer[4096];
+    ssize_t bytesRead;
+    while ((bytesRead = read(channel[0], buffer, sizeof(buffer))) > 0) {
+        report.append(buffer, bytesRead);
+    }
+    close(channel[0]);
+
+    int status = 0;
+    struct rusage usage;
+    wait4(pid, &status, 0, &usage);
+    result.peakRssKb = usage.ru_maxrss;
+
+    if (WIFSIGNALED(status)) {
+        result.status = WTERMSIG(status) == SIGALRM ? "timeout" : "error";
+        result.message = WTERMSIG(status) == SIGALRM ? "over budget" : strsignal(WTERMSIG(status));
+        return result;
+    }
+    std::istringstream fields(report);
+    fields >> result.status >> result.runtimeMs >> result.cost;
+    std::getline(fields >> std::ws, result.message);
+    if (result.status.empty()) {
+        result.status = "error";
+        result.message = "no result";
+    }
+    return result;
+}
+
+std::string gapText(const BenchResult& result) {
+    if (result.cost < 0 || result.bestKnown <= 0) return "";
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", 100.0 * (result.cost - result.bestKnown) / result.bestKnown);
+    return buffer;
+}
+
+const char* CSV_HEADER = "instance,nodes,algorithm,seed,status,runtime_ms,peak_rss_kb,cost,best_known,gap_pct,message";
+
+std::string toCsv(const BenchResult& result) {
+    std::string message = result.message;
+    std::replace(message.begin(), message.end(), ',', ';');
+    char runtime[32];
+    std::snprintf(runtime, sizeof(runtime), "%.3f", result.runtimeMs);
+    return result.instance + "," + std::to_string(result.nodes) + "," + result.algorithm + "," +
+           std::to_string(result.seed) + "," + result.status + "," + runtime + "," +
+           std::to_string(result.peakRssKb) + "," + std::to_string(result.cost) + "," +
+           std::to_string(result.bestKnown) + "," + gapText(result) + "," + message;
+}
+
+std::string toJsonObject(const BenchResult& result) {
+    std::string gap = gapText(result);
+    return "{\"instance\":" + jsonQuote(result.instance) + ",\"nodes\":" + std::to_string(result.nodes) +
+           ",\"algorithm\":" + jsonQuote(result.algorithm) + ",\"seed\":" + std::to_string(result.seed) +
+           ",\"status\":" + jsonQuote(result.status) + ",\"runtime_ms\":" + std::to_string(result.runtimeMs) +
+           ",\"peak_rss_kb\":" + std::to_string(result.peakRssKb) + ",\"cost\":" + std::to_string(result.cost) +
+           ",\"best_known\":" + std::to_string(result.bestKnown) +
+           ",\"gap_pct\":" + (gap.empty() ? "null" : gap) + ",\"message\":" + jsonQuote(result.message) + "}";
+}
+
+// Rows of a previous CSV run that got slower or produced worse routes.
+// Runs under 5 ms are too noisy to compare on time.
+int reportRegressions(const std::string& previousFile, const std::vector<BenchResult>& results, double tolerance) {
+    std::ifstream file(previousFile);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening comparison file: " + previousFile);
+    }
+    std::map<std::pair<std::string, std::string>, std::pair<double, long long>> previous;
+    std::string line;
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ',')) fields.push_back(field);
+        if (fields.size() < 8 || fields[4] != "ok") continue;
+        previous[{fields[0], fields[2]}] = {std::atof(fields[5].c_str()), std::atoll(fields[7].c_str())};
+    }
+
+    int regressions = 0;
+    for (const auto& result : results) {
+        auto found = previous.find({result.instance, result.algorithm});
+        if (found == previous.end()) continue;
+        double oldRuntime = found->second.first;
+        long long oldCost = found->second.second;
+        std::string what;
+        if (result.status != "ok") {
+            what = result.status;
+        } else if (oldRuntime >= 5.0 && result.runtimeMs > oldRuntime * (1.0 + tolerance)) {
+            what = "runtime " + std::to_string(oldRuntime) + " -> " + std::to_string(result.runtimeMs) + " ms";
+        } else if (result.cost > oldCost) {
+            what = "cost " + std::to_string(oldCost) + " -> " + std::to_string(result.cost);
+        }
+        if (!what.empty()) {
+            std::cerr << "REGRESSION " << result.instance << " " << result.algorithm << ": " << what << std::endl;
+            regressions++;
+        }
+    }
+    std::cerr << regressions << " regression(s) against " << previousFile << std::endl;
+    return regressions;
+}
+
+int main(int argc, char** argv) try {
+    CommandLine commandLine = parseCommandLine(argc, argv);
+    auto algorithms = splitList(commandLine.get("algorithms", DEFAULT_ALGORITHMS));
+    int defaultVehicles = commandLine.getNumber("vehicles", 3);
+    unsigned seed = commandLine.getNumber("seed", 1);
+    int budgetSeconds = commandLine.getNumber("budget", 30);
+    double maxMatrixMb = commandLine.getNumber("max-matrix-mb", 4096);
+    int threads = commandLine.getNumber("threads", 1);
+    std::string format = commandLine.get("format", "csv");
+    std::string distanceType = commandLine.get("distance-type", "auto");
+
+    // Instance files first, then the synthetic size ladder
+    std::vector<std::string> files = splitList(commandLine.get("instances"));
+    std::vector<std::string> sizes = splitList(commandLine.get("synthetic", files.empty() ? DEFAULT_SIZES : ""));
+
+    std::ofstream outputFile;
+    if (commandLine.has("output")) {
+        outputFile.open(commandLine.get("output"));
+        if (!outputFile.is_open()) {
+            throw std::runtime_error("Error opening output file: " + commandLine.get("output"));
+        }
+    }
+    std::ostream& out = outputFile.is_open() ? outputFile : std::cout;
+    if (format == "csv") {
+        out << CSV_HEADER << std::endl;
+    } else {
+        out << "[" << std::endl;
+    }
+
+    std::vector<BenchResult> results;
+    auto emit = [&](const BenchResult& result) {
+        if (format == "csv") {
+            out << toCsv(result) << std::endl;
+        } else {
+            out << (results.empty() ? "  " : ", ") << toJsonObject(result) << std::endl;
+        }
+        results.push_back(result);
+        std::cerr << result.instance << " " << result.algorithm << ": " << result.status
+                  << " " << result.runtimeMs << " ms, cost " << result.cost << std::endl;
+    };
+
+    auto runAll = [&](const Instance& instance) {
+        int numVehicles = instance.vehicles > 0 ? instance.vehicles : defaultVehicles;
+        for (const auto& algorithm : algorithms) {
+            emit(benchmark(instance, algorithm, numVehicles, seed, budgetSeconds, distanceType));
+        }
+    };
+
+    for (const auto& file : files) {
+        runAll(loadTsplibInstance(file, threads));
+    }
+    for (const auto& size : sizes) {
+        int numCustomers = std::atoi(size.c_str());
+        if (matrixBytes(numCustomers) / 1e6 > maxMatrixMb) {
+            // Too big for a dense matrix in the allowed memory
+            for (const auto& algorithm : algorithms) {
+                BenchResult result;
+                result.instance = "uniform-" + size + "-s" + std::to_string(seed);
+                result.nodes = numCustomers;
+                result.algorithm = algorithm;
+                result.seed = seed;
+                result.status = "skipped";
+                result.message = "matrix needs " + std::to_string(matrixBytes(numCustomers) >> 20) + " MB";
+                emit(result);
+            }
+            continue;
+        }
+        runAll(syntheticInstance(numCustomers, seed, threads));
+    }
+
+    if (format != "csv") {
+        out << "]" << std::endl;
+    }
+
+    if (commandLine.has("compare")) {
+        double tolerance = commandLine.getNumber("tolerance", 0.10);
+        return reportRegressions(commandLine.get("compare"), results, tolerance) > 0 ? 2 : 0;
+    }
+    return 0;
+} catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+}
@@ -0,0 +1,78 @@
+#include "geo_matrix.h"
+#include "table_backend.h"
+#include "telemetry.h"
+
+// Usage: vrp_matrix [--input coordinates.txt] [--output input.txt|input.bin]
+//          [--backend haversine|equirectangular|osrm|recorded] [--threads T]
+//          [--url http://host:port] [--profile driving] [--batch 100]
+//          [--recorded table.json] [--record table.json] [--cache DIR] [--cache-mb 256]
+//          [--distance-type int32|uint16|auto] [--telemetry[=FILE]]
+//
+// Builds the distance matrix the solvers read from "lat lon" lines, depot
+// first. haversine and equirectangular compute straight-line meters locally;
+// osrm asks an OSRM-compatible /table service for road meters in batches, and
+// recorded replays a table saved earlier with --record. The output is the
+// legacy text matrix, or the binary format when the name ends in ".bin".
+// Binary files hold int32 cells unless --distance-type asks for uint16 (or
+// auto, uint16 when every distance fits), which halves the file and the
+// memory the solvers map.
+// With --cache, osrm tables are kept in DIR (LRU, at most --cache-mb) and a
+// point set seen before, or mostly seen before, only fetches what is new.
+int main(int argc, char** argv) try {
+    CommandLine commandLine = parseCommandLine(argc, argv);
+    Telemetry telemetry;
+    Telemetry* probe = telemetryFromCommandLine(commandLine, telemetry);
+    std::string backend = commandLine.get("backend", "haversine");
+    std::string output = commandLine.get("output", "input.txt");
+    int threads = commandLine.getNumber("threads", std::max(1u, std::thread::hardware_concurrency()));
+
+    auto points = timePhase(probe, "parse", [&] {
+        return readCoordinates(commandLine.get("input", "coordinates.txt"));
+    });
+
+    auto matrix = timePhase(probe, "build", [&] {
+        if (backend == "haversine") {
+            return haversineMatrix(points, threads);
+        }
+        if (backend == "equirectangular") {
+            return equirectangularMatrix(points, threads);
+        }
+        if (backend == "osrm") {
+            TableParams params;
+            params.url = commandLine.get("url", params.url);
+            params.profile = commandLine.get("profile", params.profile);
+            params.batch = commandLine.getNumber("batch", params.batch);
+            params.threads = commandLine.getNumber("threads", params.threads);
+            params.telemetry = probe;
+            if (commandLine.has("cache")) {
+                double megabytes = commandLine.getNumber("cache-mb", 256.0);
+                DiskCache cache(commandLine.get("cache"), size_t(megabytes * 1024 * 1024));
+                return cachedTableMatrix(points, params, cache);
+            }
+            return osrmTableMatrix(points, params);
+        }
+        if (backend == "recorded") {
+            return recordedTableMatrix(points, commandLine.get("recorded", "table.json"));
+        }
+        throw std::runtime_error("Unknown backend: " + backend);
+    });
+
+    timePhase(probe, "write", [&] {
+        if (output.size() > 4 && output.compare(output.size() - 4, 4, ".bin") == 0) {
+            chooseDistanceType(matrix, commandLine.get("distance-type", "int32")).visit([&](const auto& stored) {
+                writeBinaryDistanceMatrix(stored, output);
+            });
+        } else {
+            writeTextDistanceMatrix(matrix, output);
+        }
+        if (commandLine.has("record")) {
+            writeRecordedTable(points, matrix, commandLine.get("record"));
+        }
+    });
+    writeTelemetry(commandLine, probe, "vrp_matrix", matrix);
+
+    return 0;
+} catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+}
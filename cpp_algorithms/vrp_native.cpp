@@ -0,0 +1,529 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "solvers.h"
+#include "local_search.h"
+#include "cache.h"
+
+// In-process Python module: import vrp_native
+// Solves on a matrix handed over through the buffer protocol, so a NumPy
+// array (or array.array, memoryview, ...) is read where it lies instead of
+// going through a subprocess, a JSON request or input/output files. The GIL
+// is released for the whole solve, so other Python threads keep running and
+// concurrent solves run in parallel.
+//
+// solve(matrix, algorithm, vehicles=2, *, local_search=False, time_limit=0.0,
+//       seed=0, distance_type="auto", demands=None, capacity=0,
+//       time_windows=None, service_times=None, on_improvement=None,
+//       cache_dir=None, cache_mb=256.0, racers=None, details=False)
+//       -> (routes, costs), or (routes, costs, details) with details=True
+//   matrix: (N+1) x (N+1) distances with the depot at index 0, 2-D or flat.
+//           C-contiguous rows of int32 cells are used without a copy, and so
+//           are uint16 rows with at least one spare cell after the last node
+//           (the vector kernels read one cell past the row); any other
+//           integer layout is copied into an int32 matrix
+//   algorithm: any name in ALGORITHMS; the options mean the same as for
+//           vrp_server, and "auto" keeps the buffer's cell type when it is
+//           used without a copy (as for binary matrix files)
+//   on_improvement(routes, distance) is called with the GIL held for each
+//           new best of an anytime solve; an exception in it stops the solve
+//   cache_dir shares solutions with vrp_server (see cache.h)
+//   algorithm "portfolio" races solvers on one thread each within time_limit
+//           (portfolio.h); racers names them (default nearest_neighbor,
+//           clarke_wright, simulated_annealing, genetic_algorithm)
+//   details: {"winner": the solver whose routes were returned (None for a
+//           portfolio answer from the cache), "runs": each racer's
+//           {"algorithm", "status", "distance", "elapsed_ms"[, "error"]}}
+//   Returns routes as a list of array('i') and the distance of each route
+//   as an array('q'), both priced on the matrix as given.
+
+namespace {
+
+PyObject* arrayType = nullptr;
+
+// A Python error is already set; unwind to the module function
+struct PythonError {};
+
+// Python integer sequence (or None) as a vector
+std::vector<int> intList(PyObject* object, const char* what) {
+    std::vector<int> values;
+    if (object == nullptr || object == Py_None) {
+        return values;
+    }
+    PyObject* sequence = PySequence_Fast(object, what);
+    if (sequence == nullptr) {
+        throw PythonError();
+    }
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+    for (Py_ssize_t i = 0; i < count; i++) {
+        long value = PyLong_AsLong(PySequence_Fast_GET_ITEM(sequence, i));
+        if (value == -1 && PyErr_Occurred()) {
+            Py_DECREF(sequence);
+            throw PythonError();
+        }
+        values.push_back(int(value));
+    }
+    Py_DECREF(sequence);
+    return values;
+}
+
+// Python string sequence (or None) as a vector
+std::vector<std::string> stringList(PyObject* object, const char* what) {
+    std::vector<std::string> values;
+    if (object == nullptr || object == Py_None) {
+        return values;
+    }
+    PyObject* sequence = PySequence_Fast(object, what);
+    if (sequence == nullptr) {
+        throw PythonError();
+    }
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(sequence); i++) {
+        const char* value = PyUnicode_AsUTF8(PySequence_Fast_GET_ITEM(sequence, i));
+        if (value == nullptr) {
+            Py_DECREF(sequence);
+            throw PythonError();
+        }
+        values.push_back(value);
+    }
+    Py_DECREF(sequence);
+    return values;
+}
+
+void readConstraints(PyObject* demands, int capacity, PyObject* timeWindows, PyObject* serviceTimes,
+                     Constraints& constraints) {
+    constraints.demands = intList(demands, "demands must be a sequence of integers");
+    constraints.capacity = capacity;
+    if (timeWindows != nullptr && timeWindows != Py_None) {
+        PyObject* windows = PySequence_Fast(timeWindows, "time_windows must be a sequence of (ready, due) pairs");
+        if (windows == nullptr) {
+            throw PythonError();
+        }
+        for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(windows); i++) {
+            std::vector<int> window;
+            try {
+                window = intList(PySequence_Fast_GET_ITEM(windows, i), "time_windows must hold (ready, due) pairs");
+            } catch (const PythonError&) {
+                Py_DECREF(windows);
+                throw;
+            }
+            if (window.size() != 2) {
+                Py_DECREF(windows);
+                PyErr_SetString(PyExc_ValueError, "time_windows must hold (ready, due) pairs");
+                throw PythonError();
+            }
+            constraints.ready.push_back(window[0]);
+            constraints.due.push_back(window[1]);
+        }
+        Py_DECREF(windows);
+        constraints.service = intList(serviceTimes, "service_times must be a sequence of integers");
+        if (constraints.service.empty()) {
+            constraints.service.assign(constraints.ready.size(), 0);
+        }
+    }
+}
+
+// Buffer protocol view of the matrix, released when the solve is done
+class MatrixBuffer {
+public:
+    explicit MatrixBuffer(PyObject* object) {
+        if (PyObject_GetBuffer(object, &view, PyBUF_STRIDES | PyBUF_FORMAT) != 0) {
+            throw PythonError();
+        }
+        held = true;
+        if (view.ndim == 2) {
+            rows = view.shape[0];
+            columns = view.shape[1];
+            rowBytes = view.strides[0];
+            cellBytes = view.strides[1];
+        } else if (view.ndim == 1) {
+            // Flat buffer of a square matrix
+            rows = columns = Py_ssize_t(std::llround(std::sqrt(double(view.shape[0]))));
+            rowBytes = columns * view.strides[0];
+            cellBytes = view.strides[0];
+        }
+        if (rows < 1 || rows != columns || (view.ndim == 1 && rows * columns != view.shape[0])) {
+            fail(PyExc_ValueError, "matrix must be square, (N+1) x (N+1) with the depot at index 0");
+        }
+        // Native byte order only; '=', '@' and (on little-endian hosts) '<' qualify
+        const char* format = view.format != nullptr ? view.format : "B";
+        if (*format == '@' || *format == '=' || (*format == '<' && PY_LITTLE_ENDIAN)) {
+            format++;
+        }
+        type = *format != '\0' && format[1] == '\0' ? *format : '?';
+        if (std::strchr("bBhHiIlLqQ", type) == nullptr) {
+            fail(PyExc_TypeError, "matrix cells must be native-endian integers");
+        }
+    }
+
+    ~MatrixBuffer() {
+        if (held) {
+            PyBuffer_Release(&view);
+        }
+    }
+
+    MatrixBuffer(const MatrixBuffer&) = delete;
+    MatrixBuffer& operator=(const MatrixBuffer&) = delete;
+
+    int customers() const { return int(rows - 1); }
+
+    // Rows can be wrapped in place: contiguous cells and whole-cell row strides
+    bool wrappable(Py_ssize_t itemsize, Py_ssize_t minimumStride) const {
+        return view.itemsize == itemsize && cellBytes == itemsize && rowBytes > 0 && rowBytes % itemsize == 0 &&
+               rowBytes / itemsize >= minimumStride;
+    }
+
+    // The matrix without a copy where the layout allows, else an int32 copy;
+    // copied is set when the cells were copied
+    LoadedMatrix load(bool& copied) const {
+        LoadedMatrix loaded;
+        copied = false;
+        if ((type == 'i' || type == 'l') && wrappable(sizeof(int), rows)) {
+            loaded.wide = DistanceMatrix::wrap(customers(), rowBytes / sizeof(int), nullptr, static_cast<int*>(view.buf));
+            return loaded;
+        }
+        if (type == 'H' && wrappable(sizeof(uint16_t), rows + 1)) {
+            loaded.compact = CompactDistanceMatrix::wrap(customers(), rowBytes / sizeof(uint16_t), nullptr,
+                                                         static_cast<uint16_t*>(view.buf));
+            loaded.isCompact = true;
+            return loaded;
+        }
+        copied = true;
+        loaded.wide = DistanceMatrix(customers());
+        for (Py_ssize_t i = 0; i < rows; i++) {
+            const char* row = static_cast<const char*>(view.buf) + i * rowBytes;
+            for (Py_ssize_t j = 0; j < rows; j++) {
+                loaded.wide.set(int(i), int(j), cell(row + j * cellBytes));
+            }
+        }
+        return loaded;
+    }
+
+private:
+    Py_buffer view;
+    bool held = false;
+    Py_ssize_t rows = 0;
+    Py_ssize_t columns = 0;
+    Py_ssize_t rowBytes = 0;
+    Py_ssize_t cellBytes = 0;
+    char type = '?';
+
+    [[noreturn]] void fail(PyObject* exception, const char* message) {
+        PyErr_SetString(exception, message);
+        throw PythonError();
+    }
+
+    int cell(const char* p) const {
+        long long value = 0;
+        switch (view.itemsize) {
+            case 1: value = (type == 'b') ? *reinterpret_cast<const int8_t*>(p) : *reinterpret_cast<const uint8_t*>(p); break;
+            case 2: {
+                int16_t bits;
+                std::memcpy(&bits, p, 2);
+                value = (type == 'h') ? bits : uint16_t(bits);
+                break;
+            }
+            case 4: {
+                int32_t bits;
+                std::memcpy(&bits, p, 4);
+                value = std::islower(type) ? bits : uint32_t(bits);
+                break;
+            }
+            default: std::memcpy(&value, p, 8); break;
+        }
+        if (value > std::numeric_limits<int>::max() || value < std::numeric_limits<int>::min()) {
+            throw std::runtime_error("Error: matrix distance " + std::to_string(value) + " does not fit int32");
+        }
+        return int(value);
+    }
+};
+
+// Cell type the solve runs on; a matrix used in place keeps its type under
+// "auto", a copied one is stored like a text matrix file
+LoadedMatrix solveMatrix(const LoadedMatrix& input, bool copied, const std::string& type) {
+    if (type == "int32" && input.isCompact) {
+        LoadedMatrix loaded;
+        loaded.wide = convertDistanceMatrix<int>(input.compact);
+        return loaded;
+    }
+    if ((type == "auto" && !copied) || (type == "uint16" && input.isCompact)) {
+        return input;
+    }
+    return chooseDistanceType(input.wide, type);
+}
+
+PyObject* intArray(const char* typecode, const void* data, size_t bytes) {
+    return PyObject_CallFunction(arrayType, "sy#", typecode, static_cast<const char*>(data), Py_ssize_t(bytes));
+}
+
+// Store value (a new reference, or nullptr after an error) under key; the
+// reference is dropped either way
+bool setItem(PyObject* dict, const char* key, PyObject* value) {
+    bool stored = value != nullptr && PyDict_SetItemString(dict, key, value) == 0;
+    Py_XDECREF(value);
+    return stored;
+}
+
+PyObject* routesToList(const std::vector<std::vector<int>>& routes) {
+    PyObject* list = PyList_New(Py_ssize_t(routes.size()));
+    if (list == nullptr) {
+        return nullptr;
+    }
+    for (size_t r = 0; r < routes.size(); r++) {
+        PyObject* route = intArray("i", routes[r].data(), routes[r].size() * sizeof(int));
+        if (route == nullptr) {
+            Py_DECREF(list);
+            return nullptr;
+        }
+        PyList_SET_ITEM(list, Py_ssize_t(r), route);
+    }
+    return list;
+}
+
+PyObject* solve(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"matrix", "algorithm", "vehicles", "local_search", "time_limit", "seed",
+                                     "distance_type", "demands", "capacity", "time_windows", "service_times",
+                                     "on_improvement", "cache_dir", "cache_mb", "racers", "details", nullptr};
+    PyObject* matrixObject = nullptr;
+    const char* algorithm = nullptr;
+    int numVehicles = 2;
+    int improve = 0;
+    double timeLimit = 0.0;
+    unsigned long seed = 0;
+    const char* distanceType = "auto";
+    PyObject* demands = nullptr;
+    int capacity = 0;
+    PyObject* timeWindows = nullptr;
+    PyObject* serviceTimes = nullptr;
+    PyObject* onImprovement = nullptr;
+    const char* cacheDirectory = nullptr;
+    double cacheMegabytes = 256;
+    PyObject* racers = nullptr;
+    int wantDetails = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "Os|i$pdksOiOOOzdOp", const_cast<char**>(keywords), &matrixObject,
+                                     &algorithm, &numVehicles, &improve, &timeLimit, &seed, &distanceType, &demands,
+                                     &capacity, &timeWindows, &serviceTimes, &onImprovement, &cacheDirectory,
+                                     &cacheMegabytes, &racers, &wantDetails)) {
+        return nullptr;
+    }
+    if (onImprovement == Py_None) {
+        onImprovement = nullptr;
+    }
+    if (onImprovement != nullptr && !PyCallable_Check(onImprovement)) {
+        PyErr_SetString(PyExc_TypeError, "on_improvement must be callable");
+        return nullptr;
+    }
+    if (findSolverEntry(algorithm) == nullptr) {
+        PyErr_SetString(PyExc_ValueError, (std::string("unknown algorithm: ") + algorithm).c_str());
+        return nullptr;
+    }
+    if (numVehicles < 1) {
+        PyErr_SetString(PyExc_ValueError, "vehicles must be at least 1");
+        return nullptr;
+    }
+
+    try {
+        MatrixBuffer buffer(matrixObject);
+        Constraints constraints;
+        readConstraints(demands, capacity, timeWindows, serviceTimes, constraints);
+        std::string algorithmName = algorithm;
+        std::string type = distanceType;
+        std::string cachePath = cacheDirectory != nullptr ? cacheDirectory : "";
+        PortfolioParams race;
+        race.seed = unsigned(seed);
+        if (racers != nullptr && racers != Py_None) {
+            race.algorithms = stringList(racers, "racers must be a sequence of algorithm names");
+        }
+        std::string winner = algorithmName;
+        std::vector<PortfolioRun> runs;
+
+        // The callback re-acquires the GIL; an exception in it cancels the solve
+        SolveControl control;
+        if (timeLimit > 0.0) {
+            control.setTimeLimit(timeLimit);
+        }
+        PyObject* callbackError = nullptr;
+        PyObject* callbackErrorValue = nullptr;
+        PyObject* callbackTraceback = nullptr;
+        if (onImprovement != nullptr) {
+            control.onImprovement([&](const std::vector<std::vector<int>>& routes, int distance) {
+                PyGILState_STATE state = PyGILState_Ensure();
+                if (callbackError == nullptr) {
+                    PyObject* list = routesToList(routes);
+                    PyObject* result = list != nullptr ? PyObject_CallFunction(onImprovement, "Oi", list, distance)
+                                                       : nullptr;
+                    Py_XDECREF(list);
+                    if (result == nullptr) {
+                        PyErr_Fetch(&callbackError, &callbackErrorValue, &callbackTraceback);
+                        control.cancel();
+                    }
+                    Py_XDECREF(result);
+                }
+                PyGILState_Release(state);
+            });
+        }
+
+        std::vector<std::vector<int>> routes;
+        std::vector<long long> costs;
+        std::string failure;
+        Py_BEGIN_ALLOW_THREADS
+        try {
+            bool copied = false;
+            LoadedMatrix input = buffer.load(copied);
+            const Constraints* limits = nullptr;
+            input.visit([&](const auto& matrix) { constraints.validate(matrix); });
+            if (constraints.active()) {
+                limits = &constraints;
+            }
+            race.constraints = limits;
+            race.control = &control;
+
+            std::unique_ptr<DiskCache> cache;
+            std::string key, stored;
+            if (!cachePath.empty()) {
+                cache.reset(new DiskCache(cachePath, size_t(cacheMegabytes * 1024 * 1024)));
+                std::string variant = algorithmName + "/" + type;
+                if (algorithmName == "portfolio") {
+                    variant += "/" + portfolioRacerList(race);
+                }
+                key = input.visit([&](const auto& matrix) {
+                    return solutionKey(variant, matrix, numVehicles, unsigned(seed), improve != 0,
+                                       timeLimit * 1000.0, limits);
+                });
+            }
+            if (cache != nullptr && cache->load(key, stored)) {
+                if (algorithmName == "portfolio") {
+                    winner.clear();
+                }
+                for (const auto& route : parseJson(stored).array) {
+                    routes.emplace_back();
+                    for (const auto& node : route.array) {
+                        routes.back().push_back(static_cast<int>(node.number));
+                    }
+                }
+            } else {
+                routes = solveMatrix(input, copied, type).visit([&](const auto& cells) {
+                    using Matrix = std::decay_t<decltype(cells)>;
+                    std::vector<std::vector<int>> found;
+                    if (algorithmName == "portfolio") {
+                        PortfolioResult result = portfolioRace(cells, numVehicles, race);
+                        winner = result.winner;
+                        runs = std::move(result.runs);
+                        found = std::move(result.routes);
+                    } else {
+                        found = runSolverEntry(*findSolverEntry<Matrix>(algorithmName), cells, numVehicles, limits,
+                                               &control, unsigned(seed));
+                    }
+                    if (improve) {
+                        LocalSearchParams search;
+                        search.control = &control;
+                        search.constraints = limits;
+                        found = localSearchVRP(cells, found, search);
+                    }
+                    return found;
+                });
+                // A solve cancelled by a raising callback only returns the error
+                if (cache != nullptr && callbackError == nullptr && !control.cancelRequested()) {
+                    cache->store(key, routesToJson(routes));
+                }
+            }
+            input.visit([&](const auto& matrix) {
+                for (const auto& route : routes) {
+                    costs.push_back(calculateRouteDistance(route, matrix));
+                }
+            });
+        } catch (const std::exception& e) {
+            failure = e.what();
+        }
+        Py_END_ALLOW_THREADS
+
+        if (callbackError != nullptr) {
+            PyErr_Restore(callbackError, callbackErrorValue, callbackTraceback);
+            return nullptr;
+        }
+        if (!failure.empty()) {
+            PyErr_SetString(PyExc_RuntimeError, failure.c_str());
+            return nullptr;
+        }
+        PyObject* routeList = routesToList(routes);
+        if (routeList == nullptr) {
+            return nullptr;
+        }
+        PyObject* costArray = intArray("q", costs.data(), costs.size() * sizeof(long long));
+        if (costArray == nullptr) {
+            Py_DECREF(routeList);
+            return nullptr;
+        }
+        if (!wantDetails) {
+            return Py_BuildValue("(NN)", routeList, costArray);
+        }
+        PyObject* runList = PyList_New(0);
+        for (size_t k = 0; runList != nullptr && k < runs.size(); k++) {
+            const PortfolioRun& run = runs[k];
+            PyObject* entry = Py_BuildValue("{s:s,s:s,s:d}", "algorithm", run.algorithm.c_str(), "status",
+                                            run.status.c_str(), "elapsed_ms", run.elapsedMs);
+            bool added = entry != nullptr &&
+                         (run.distance < 0 || setItem(entry, "distance", PyLong_FromLong(run.distance))) &&
+                         (run.error.empty() || setItem(entry, "error", PyUnicode_FromString(run.error.c_str()))) &&
+                         PyList_Append(runList, entry) == 0;
+            Py_XDECREF(entry);
+            if (!added) {
+                Py_CLEAR(runList);
+            }
+        }
+        const char* winnerName = winner.empty() ? nullptr : winner.c_str();
+        PyObject* details =
+            runList != nullptr ? Py_BuildValue("{s:z,s:N}", "winner", winnerName, "runs", runList) : nullptr;
+        if (details == nullptr) {
+            Py_DECREF(routeList);
+            Py_DECREF(costArray);
+            return nullptr;
+        }
+        return Py_BuildValue("(NNN)", routeList, costArray, details);
+    } catch (const PythonError&) {
+        return nullptr;
+    } catch (const std::exception& e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+}
+
+PyMethodDef methods[] = {
+    {"solve", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(solve)), METH_VARARGS | METH_KEYWORDS,
+     "solve(matrix, algorithm, vehicles=2, *, local_search=False, time_limit=0.0, seed=0, distance_type='auto', "
+     "demands=None, capacity=0, time_windows=None, service_times=None, on_improvement=None, cache_dir=None, "
+     "cache_mb=256.0, racers=None, details=False) -> (routes, costs[, details])"},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyModuleDef moduleDefinition = {
+    PyModuleDef_HEAD_INIT, "vrp_native", "In-process VRP solvers over buffer-protocol distance matrices", -1, methods,
+    nullptr, nullptr, nullptr, nullptr,
+};
+
+}  // namespace
+
+PyMODINIT_FUNC PyInit_vrp_native() {
+    PyObject* arrayModule = PyImport_ImportModule("array");
+    if (arrayModule == nullptr) {
+        return nullptr;
+    }
+    arrayType = PyObject_GetAttrString(arrayModule, "array");
+    Py_DECREF(arrayModule);
+    if (arrayType == nullptr) {
+        return nullptr;
+    }
+    PyObject* module = PyModule_Create(&moduleDefinition);
+    if (module == nullptr) {
+        return nullptr;
+    }
+    const auto& registry = solverRegistry<DistanceMatrix>();
+    PyObject* names = PyTuple_New(Py_ssize_t(registry.size()));
+    for (size_t i = 0; names != nullptr && i < registry.size(); i++) {
+        PyTuple_SET_ITEM(names, Py_ssize_t(i), PyUnicode_FromString(registry[i].name));
+    }
+    if (names == nullptr || PyModule_AddObject(module, "ALGORITHMS", names) != 0) {
+        Py_XDECREF(names);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
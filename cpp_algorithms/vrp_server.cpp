@@ -0,0 +1,573 @@
+#include "solvers.h"
+#include "json.h"
+#include "local_search.h"
+#include "reoptimize.h"
+#include "cache.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <chrono>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Long-running solver daemon
+// Reads newline-delimited JSON requests from stdin (or from each connection
+// on a Unix socket with --socket PATH) and answers every request with one
+// JSON line carrying the request's id. Requests are solved concurrently on a
+// worker pool, so responses may arrive in a different order than requests.
+//
+// Request:  {"id": 1, "algorithm": "clarke_wright", "vehicles": 2,
+//            "matrix": [[...], ...]}        (or "matrix_file": "input.bin")
+//           optional "local_search": true runs the local search stage on the result,
+//           "time_limit_ms": T stops the GA/SA/local search at the deadline (the GA
+//           then evolves until it), and "stream": true sends every new best first as
+//           {"id": 1, "event": "improvement", "elapsed_ms": 12.5, "distance": 1300, "routes": [...]}
+//           optional constraints, one entry per node with the depot first:
+//           "demands": [...], "capacity": Q, "time_windows": [[ready, due], ...],
+//           "service_times": [...]; nearest_neighbor and clarke_wright build
+//           feasible routes, the local search stage enforces them for any solver
+//           optional "seed": S fixes the GA/SA random seed (0, the default, seeds from the clock)
+//           With --cache DIR a solution is stored under a hash of the matrix, vehicles,
+//           algorithm, seed and options, and an identical request is answered from
+//           the cache ("cached": true); "cache": false bypasses it for one request
+//           Warm start instead of a solver: "previous_routes": [[0, 3, 1, 0], ...] with
+//           optional "added": [...], "removed": [...] (node numbers in the matrix) and
+//           "vehicles" (default: keep the fleet) reoptimizes around the change;
+//           "local_search": false skips the search after the insertions
+//           optional "distance_type": "auto" (default), "int32" or "uint16" picks the
+//           matrix cell type the solve runs on; "distance" is always priced on the int32 matrix
+//           "algorithm": "portfolio" races nearest_neighbor, clarke_wright, simulated_annealing
+//           and genetic_algorithm within "time_limit_ms" (portfolio.h); "racers": [...] picks others
+// Response: {"id": 1, "algorithm": "clarke_wright", "routes": [[0, 2, 0], ...],
+//            "distance": 1234, "route_distances": [700, 534], "solve_ms": 0.8}
+//           (plus "violation" with constraints, and for a portfolio solve the "winner"
+//           and each racer's "runs": [{"algorithm", "status", "distance", "elapsed_ms"}, ...])
+//           {"id": 1, "error": "..."}
+
+// Serialized writer for one client; responses from different workers never interleave
+class ResponseSink {
+public:
+    ResponseSink(int fd, bool ownsFd) : fd(fd), ownsFd(ownsFd) {}
+
+    ~ResponseSink() {
+        if (ownsFd) {
+            close(fd);
+        }
+    }
+
+    void send(std::string line) {
+        line += '\n';
+        std::lock_guard<std::mutex> lock(mutex);
+        const char* data = line.data();
+        size_t remaining = line.size();
+        while (remaining > 0) {
+            ssize_t written = write(fd, data, remaining);
+            if (written <= 0) {
+                return; // Client went away; drop the response
+            }
+            data += written;
+            remaining -= written;
+        }
+    }
+
+private:
+    int fd;
+    bool ownsFd;
+    std::mutex mutex;
+};
+
+// Fixed set of worker threads draining a FIFO of jobs
+class WorkerPool {
+public:
+    explicit WorkerPool(int numThreads) {
+        for (int i = 0; i < numThreads; i++) {
+            workers.emplace_back([this] { run(); });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+            pending++;
+        }
+        wake.notify_one();
+    }
+
+    // Block until every submitted job has finished
+    void drain() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return pending == 0; });
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    int pending = 0;
+    bool stopping = false;
+
+    void run() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending--;
+            }
+            idle.notify_all();
+        }
+    }
+};
+
+// Build a matrix from JSON rows: either the legacy N rows of N+1 columns
+// written by vrp_solver.py, or a full (N+1)x(N+1) matrix with the depot row first
+DistanceMatrix matrixFromJson(const JsonValue& rows) {
+    if (!rows.isArray() || rows.array.empty()) {
+        throw std::runtime_error("matrix must be a non-empty array of rows");
+    }
+    int numRows = rows.array.size();
+    int numColumns = rows.array[0].isArray() ? rows.array[0].array.size() : 0;
+    bool legacy = (numColumns == numRows + 1);
+    if (!legacy && numColumns != numRows) {
+        throw std::runtime_error("matrix must be N x (N+1) or (N+1) x (N+1)");
+    }
+
+    int n = legacy ? numRows : numRows - 1;
+    DistanceMatrix matrix(n);
+    for (int r = 0; r < numRows; r++) {
+        const JsonValue& row = rows.array[r];
+        if (!row.isArray() || int(row.array.size()) != numColumns) {
+            throw std::runtime_error("matrix rows must all have the same length");
+        }
+        int from = legacy ? r + 1 : r;
+        for (int c = 0; c < numColumns; c++) {
+            if (!row.array[c].isNumber()) {
+                throw std::runtime_error("matrix entries must be numbers");
+            }
+            int distance = static_cast<int>(row.array[c].number);
+            if (legacy && c == 0) {
+                matrix.set(0, from, distance);
+                matrix.set(from, 0, distance);
+            } else {
+                matrix.set(from, c, distance);
+            }
+        }
+    }
+    matrix.setSymmetric(matrix.checkSymmetric());
+    return matrix;
+}
+
+// Whole number within int range
+bool isInt(const JsonValue& value) {
+    return value.isNumber() && value.number == std::floor(value.number) &&
+           value.number >= std::numeric_limits<int>::min() && value.number <= std::numeric_limits<int>::max();
+}
+
+// Entry of the integer array field what
+int intFromJson(const JsonValue& value, const char* what) {
+    if (!isInt(value)) {
+        throw std::runtime_error(std::string("\"") + what + "\" must hold integers");
+    }
+    return static_cast<int>(value.number);
+}
+
+// Optional integer, number or string field; a field of the wrong type is an
+// error rather than the fallback
+int intField(const JsonValue& request, const char* what, int fallback) {
+    const JsonValue* value = request.find(what);
+    if (value == nullptr) {
+        return fallback;
+    }
+    if (!isInt(*value)) {
+        throw std::runtime_error(std::string("\"") + what + "\" must be an integer");
+    }
+    return static_cast<int>(value->number);
+}
+
+double numberField(const JsonValue& request, const char* what, double fallback) {
+    const JsonValue* value = request.find(what);
+    if (value == nullptr) {
+        return fallback;
+    }
+    if (!value->isNumber()) {
+        throw std::runtime_error(std::string("\"") + what + "\" must be a number");
+    }
+    return value->number;
+}
+
+std::string stringField(const JsonValue& request, const char* what, const std::string& fallback) {
+    const JsonValue* value = request.find(what);
+    if (value == nullptr) {
+        return fallback;
+    }
+    if (!value->isString()) {
+        throw std::runtime_error(std::string("\"") + what + "\" must be a string");
+    }
+    return value->string;
+}
+
+// Read the optional constraint fields of a request
+bool constraintsFromJson(const JsonValue& request, const DistanceMatrix& matrix, Constraints& constraints) {
+    auto numbers = [](const JsonValue* list, const char* what) {
+        std::vector<int> values;
+        if (list == nullptr) {
+            return values;
+        }
+        if (!list->isArray()) {
+            throw std::runtime_error(std::string("\"") + what + "\" must be an array");
+        }
+        for (const auto& value : list->array) {
+            values.push_back(intFromJson(value, what));
+        }
+        return values;
+    };
+    constraints.demands = numbers(request.find("demands"), "demands");
+    constraints.capacity = intField(request, "capacity", constraints.capacity);
+    if (const JsonValue* windows = request.find("time_windows")) {
+        if (!windows->isArray()) {
+            throw std::runtime_error("\"time_windows\" must be an array of [ready, due] pairs");
+        }
+        for (const auto& window : windows->array) {
+            if (!window.isArray() || window.array.size() != 2) {
+                throw std::runtime_error("\"time_windows\" must be an array of [ready, due] pairs");
+            }
+            constraints.ready.push_back(intFromJson(window.array[0], "time_windows"));
+            constraints.due.push_back(intFromJson(window.array[1], "time_windows"));
+        }
+        constraints.service = numbers(request.find("service_times"), "service_times");
+        if (constraints.service.empty()) {
+            constraints.service.assign(constraints.ready.size(), 0);
+        }
+    }
+    constraints.validate(matrix);
+    return constraints.active();
+}
+
+// Optional true/false field; anything else is an error rather than false
+bool boolFromJson(const JsonValue& request, const char* what, bool fallback) {
+    const JsonValue* value = request.find(what);
+    if (value == nullptr) {
+        return fallback;
+    }
+    if (!value->isBool()) {
+        throw std::runtime_error(std::string("\"") + what + "\" must be true or false");
+    }
+    return value->boolean;
+}
+
+// Routes or node lists sent as JSON arrays of numbers
+std::vector<int> nodesFromJson(const JsonValue* list, const char* what) {
+    std::vector<int> nodes;
+    if (list == nullptr) {
+        return nodes;
+    }
+    if (!list->isArray()) {
+        throw std::runtime_error(std::string("\"") + what + "\" must be an array");
+    }
+    for (const auto& value : list->array) {
+        if (!value.isNumber()) {
+            throw std::runtime_error(std::string("\"") + what + "\" must hold node numbers");
+        }
+        nodes.push_back(intFromJson(value, what));
+    }
+    return nodes;
+}
+
+std::vector<std::vector<int>> routesFromJson(const JsonValue& list, const char* what) {
+    if (!list.isArray()) {
+        throw std::runtime_error(std::string("\"") + what + "\" must be an array of routes");
+    }
+    std::vector<std::vector<int>> routes;
+    for (const auto& route : list.array) {
+        routes.push_back(nodesFromJson(&route, what));
+    }
+    return routes;
+}
+
+// Distance of each route, in the order of the routes
+std::string routeDistancesToJson(const std::vector<std::vector<int>>& routes, const DistanceMatrix& matrix) {
+    std::string result = "[";
+    for (size_t r = 0; r < routes.size(); r++) {
+        if (r > 0) result += ",";
+        result += std::to_string(calculateRouteDistance(routes[r], matrix));
+    }
+    return result + "]";
+}
+
+// Solve one request line and return the response line; streamed
+// improvement events go out through emit before it. cache may be nullptr
+std::string handleRequest(const std::string& line, const std::function<void(const std::string&)>& emit,
+                          const DiskCache* cache) {
+    std::string id = "null";
+    try {
+        JsonValue request = parseJson(line);
+        if (!request.isObject()) {
+            throw std::runtime_error("request must be a JSON object");
+        }
+        if (const JsonValue* value = request.find("id")) {
+            id = toJson(*value);
+        }
+
+        // A warm start replaces the solver
+        const JsonValue* previous = request.find("previous_routes");
+        const SolverEntry<DistanceMatrix>* solver = nullptr;
+        std::string algorithmName = "reoptimize";
+        if (previous == nullptr) {
+            const JsonValue* algorithm = request.find("algorithm");
+            if (algorithm == nullptr || !algorithm->isString()) {
+                throw std::runtime_error("missing \"algorithm\"");
+            }
+            solver = findSolverEntry(algorithm->string);
+            if (solver == nullptr) {
+                throw std::runtime_error("unknown algorithm: " + algorithm->string);
+            }
+            algorithmName = algorithm->string;
+        }
+
+        int numVehicles = intField(request, "vehicles", previous != nullptr ? 0 : 2);
+        if (request.find("vehicles") != nullptr && numVehicles < 1) {
+            throw std::runtime_error("\"vehicles\" must be at least 1");
+        }
+
+        DistanceMatrix matrix;
+        if (const JsonValue* rows = request.find("matrix")) {
+            matrix = matrixFromJson(*rows);
+        } else if (request.find("matrix_file") != nullptr) {
+            matrix = readDistanceMatrix(stringField(request, "matrix_file", ""));
+        } else {
+            throw std::runtime_error("missing \"matrix\" or \"matrix_file\"");
+        }
+
+        int requestedSeed = intField(request, "seed", 0);
+        if (requestedSeed < 0) {
+            throw std::runtime_error("\"seed\" must not be negative");
+        }
+        unsigned seed = static_cast<unsigned>(requestedSeed);
+        bool improve = boolFromJson(request, "local_search", previous != nullptr);
+        if (!boolFromJson(request, "cache", true) || previous != nullptr) {
+            cache = nullptr;
+        }
+        std::string distanceType = stringField(request, "distance_type", "auto");
+
+        SolveControl control;
+        double timeLimitMs = numberField(request, "time_limit_ms", 0.0);
+        if (timeLimitMs < 0.0) {
+            throw std::runtime_error("\"time_limit_ms\" must not be negative");
+        }
+        if (request.find("time_limit_ms") != nullptr) {
+            control.setTimeLimit(timeLimitMs / 1000.0);
+        }
+        if (boolFromJson(request, "stream", false)) {
+            control.onImprovement([&](const std::vector<std::vector<int>>& routes, int distance) {
+                emit("{\"id\":" + id + ",\"event\":\"improvement\",\"elapsed_ms\":" +
+                     std::to_string(control.elapsedMs()) + ",\"distance\":" + std::to_string(distance) +
+                     ",\"routes\":" + routesToJson(routes) + "}");
+            });
+        }
+
+        Constraints constraints;
+        const Constraints* limits = constraintsFromJson(request, matrix, constraints) ? &constraints : nullptr;
+
+        PortfolioParams race;
+        race.seed = seed;
+        race.constraints = limits;
+        race.control = &control;
+        if (const JsonValue* racers = request.find("racers")) {
+            if (!racers->isArray()) {
+                throw std::runtime_error("\"racers\" must be an array of algorithm names");
+            }
+            race.algorithms.clear();
+            for (const auto& racer : racers->array) {
+                if (!racer.isString()) {
+                    throw std::runtime_error("\"racers\" must be an array of algorithm names");
+                }
+                race.algorithms.push_back(racer.string);
+            }
+        }
+        std::string raceFields;
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::vector<int>> routes;
+        std::string key, stored;
+        bool cached = false;
+        if (cache != nullptr) {
+            std::string variant = algorithmName + "/" + distanceType;
+            if (algorithmName == "portfolio") {
+                variant += "/" + portfolioRacerList(race);
+            }
+            key = solutionKey(variant, matrix, numVehicles, seed, improve, timeLimitMs, limits);
+            cached = cache->load(key, stored);
+        }
+        if (cached) {
+            routes = routesFromJson(parseJson(stored), "cached routes");
+        } else {
+            // Solve on the stored cell type; the response is priced on matrix
+            routes = chooseDistanceType(matrix, distanceType).visit([&](const auto& cells) {
+                using Matrix = std::decay_t<decltype(cells)>;
+                if (previous != nullptr) {
+                    RouteChange change;
+                    change.added = nodesFromJson(request.find("added"), "added");
+                    change.removed = nodesFromJson(request.find("removed"), "removed");
+                    change.numVehicles = numVehicles;
+                    ReoptimizeParams params;
+                    params.improve = improve;
+                    params.control = &control;
+                    params.constraints = limits;
+                    return reoptimizeRoutes(cells, routesFromJson(*previous, "previous_routes"), change, params);
+                }
+                std::vector<std::vector<int>> found;
+                if (algorithmName == "portfolio") {
+                    PortfolioResult result = portfolioRace(cells, numVehicles, race);
+                    raceFields = ",\"winner\":" + jsonQuote(result.winner) +
+                                 ",\"runs\":" + portfolioRunsToJson(result.runs);
+                    found = std::move(result.routes);
+                } else {
+                    found = runSolverEntry(*findSolverEntry<Matrix>(algorithmName), cells, numVehicles, limits,
+                                           &control, seed);
+                }
+                if (improve) {
+                    LocalSearchParams search;
+                    search.control = &control;
+                    search.constraints = limits;
+                    found = localSearchVRP(cells, found, search);
+                }
+                return found;
+            });
+            if (cache != nullptr && !control.cancelRequested()) {
+                cache->store(key, routesToJson(routes));
+            }
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        return "{\"id\":" + id + ",\"algorithm\":" + jsonQuote(algorithmName) +
+               ",\"routes\":" + routesToJson(routes) +
+               ",\"distance\":" + std::to_string(calculateTotalDistance(routes, matrix)) +
+               ",\"route_distances\":" + routeDistancesToJson(routes, matrix) +
+               ",\"solve_ms\":" + std::to_string(elapsed.count()) + (cached ? ",\"cached\":true" : "") + raceFields +
+               (limits != nullptr ? ",\"violation\":" + std::to_string(limits->violation(routes, matrix)) : "") + "}";
+    } catch (const std::exception& e) {
+        return "{\"id\":" + id + ",\"error\":" + jsonQuote(e.what()) + "}";
+    }
+}
+
+// Read request lines from fd and queue each one on the pool
+void serveStream(int fd, std::shared_ptr<ResponseSink> sink, WorkerPool& pool, const DiskCache* cache) {
+    std::string pendingLine;
+    char buffer[1 << 16];
+    while (true) {
+        ssize_t bytesRead = read(fd, buffer, sizeof(buffer));
+        if (bytesRead <= 0) {
+            break;
+        }
+        const char* chunk = buffer;
+        const char* chunkEnd = buffer + bytesRead;
+        while (chunk != chunkEnd) {
+            const char* newline = std::find(chunk, chunkEnd, '\n');
+            pendingLine.append(chunk, newline);
+            if (newline == chunkEnd) {
+                break;
+            }
+            chunk = newline + 1;
+            if (pendingLine.find_first_not_of(" \t\r") != std::string::npos) {
+                pool.submit([line = std::move(pendingLine), sink, cache] {
+                    sink->send(handleRequest(line, [&](const std::string& event) { sink->send(event); }, cache));
+                });
+            }
+            pendingLine.clear();
+        }
+    }
+    if (pendingLine.find_first_not_of(" \t\r") != std::string::npos) {
+        pool.submit([line = std::move(pendingLine), sink, cache] {
+            sink->send(handleRequest(line, [&](const std::string& event) { sink->send(event); }, cache));
+        });
+    }
+}
+
+int main(int argc, char** argv) try {
+    std::string socketPath;
+    int numThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::string cacheDirectory;
+    double cacheMegabytes = 256;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            numThreads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheDirectory = argv[++i];
+        } else if (arg == "--cache-mb" && i + 1 < argc) {
+            cacheMegabytes = std::atof(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--socket PATH] [--threads N] [--cache DIR] [--cache-mb MB]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    // A client closing its socket early must not kill the daemon
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::unique_ptr<DiskCache> cache;
+    if (!cacheDirectory.empty()) {
+        cache = std::make_unique<DiskCache>(cacheDirectory, size_t(cacheMegabytes * 1024 * 1024));
+    }
+    WorkerPool pool(numThreads);
+
+    if (socketPath.empty()) {
+        serveStream(STDIN_FILENO, std::make_shared<ResponseSink>(STDOUT_FILENO, false), pool, cache.get());
+        pool.drain();
+        return 0;
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (listener < 0 || socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Error creating socket: " + socketPath);
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    unlink(socketPath.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, 64) < 0) {
+        throw std::runtime_error("Error listening on socket: " + socketPath);
+    }
+
+    while (true) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        auto sink = std::make_shared<ResponseSink>(client, true);
+        std::thread([client, sink, &pool, &cache] { serveStream(client, sink, pool, cache.get()); }).detach();
+    }
+} catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+}
@@ -1,30 +1,38 @@
-import requests
+import os
+import subprocess
+import tempfile
 
-def get_distance_matrix(depot, deliveries):
+from vrp_solver import CACHE_DIR, CACHE_MB, ensure_binaries
+
+# Road distances come from an OSRM /table service; set OSRM_URL to use a
+# local osrm-routed instead of the public demo server
+OSRM_URL = os.environ.get("OSRM_URL", "http://router.project-osrm.org")
+
+def get_distance_matrix(depot, deliveries, backend="osrm", url=OSRM_URL):
     """
     depot: tuple (lat, lon)
     deliveries: list of tuples [(lat, lon), ...]
-    returns: N x (N+1) matrix
+    backend: "osrm" for road distances, or "haversine" / "equirectangular"
+             for straight-line distances computed locally
+    returns: N x (N+1) matrix in meters
     """
-    coords = [depot] + deliveries
-    n = len(deliveries)
-    matrix = []
-
-    for i in range(1, len(coords)):
-        row = []
-        # depot to delivery i
-        url = f"http://router.project-osrm.org/route/v1/driving/{depot[1]},{depot[0]};{coords[i][1]},{coords[i][0]}?overview=false"
-        r = requests.get(url).json()
-        row.append(int(r['routes'][0]['distance'] // 1))
-
-        for j in range(1, len(coords)):
-            if i == j:
-                row.append(0)
-                continue
-            url = f"http://router.project-osrm.org/route/v1/driving/{coords[i][1]},{coords[i][0]};{coords[j][1]},{coords[j][0]}?overview=false"
-            r = requests.get(url).json()
-            row.append(int(r['routes'][0]['distance'] // 1))
+    ensure_binaries()
+    with tempfile.TemporaryDirectory() as workdir:
+        coordinates = os.path.join(workdir, "coordinates.txt")
+        output = os.path.join(workdir, "matrix.txt")
+        with open(coordinates, "w") as f:
+            for lat, lon in [depot] + list(deliveries):
+                f.write(f"{lat} {lon}\n")
 
-        matrix.append(row)
+        # ./vrp_matrix batches the table requests and fills the matrix in parallel
+        command = ["./vrp_matrix", "--input", coordinates, "--output", output, "--backend", backend, "--url", url]
+        if CACHE_DIR:
+            # Road tables are cached; a mostly unchanged stop set only fetches its new stops
+            command += ["--cache", CACHE_DIR, "--cache-mb", CACHE_MB]
+        result = subprocess.run(command, capture_output=True, text=True)
+        if result.returncode != 0:
+            raise RuntimeError(f"vrp_matrix failed: {result.stderr.strip()}")
 
-    return matrix
+        with open(output) as f:
+            f.readline()
+            return [list(map(int, line.split())) for line in f if line.strip()]
@@ -1,10 +1,18 @@
 #!/bin/bash
-apt-get update && apt-get install -y build-essential
+apt-get update && apt-get install -y build-essential python3-dev
 cd cpp_algorithms
-g++ -o ../brute_force brute_force.cpp -std=c++17
-g++ -o ../nearest_neighbor nearest_neighbor.cpp -std=c++17
-g++ -o ../clarke_wright clarke_wright.cpp -std=c++17
-g++ -o ../genetic_algorithm genetic_algorithm.cpp -std=c++17
-g++ -o ../simulated_annealing simulated_annealing.cpp -std=c++17
+g++ -O3 -o ../brute_force brute_force.cpp -std=c++17 -pthread
+g++ -O3 -o ../nearest_neighbor nearest_neighbor.cpp -std=c++17 -pthread
+g++ -O3 -o ../clarke_wright clarke_wright.cpp -std=c++17 -pthread
+g++ -O3 -o ../genetic_algorithm genetic_algorithm.cpp -std=c++17 -pthread
+g++ -O3 -o ../simulated_annealing simulated_annealing.cpp -std=c++17 -pthread
+g++ -O3 -o ../vrp_server vrp_server.cpp -std=c++17 -pthread
+g++ -O3 -o ../vrp_bench vrp_bench.cpp -std=c++17 -pthread
+g++ -O3 -o ../vrp_matrix vrp_matrix.cpp -std=c++17 -pthread
+g++ -O3 -o ../reoptimize reoptimize.cpp -std=c++17 -pthread
+g++ -O3 -o ../vrp_batch vrp_batch.cpp -std=c++17 -pthread
+g++ -O3 -o ../decompose decompose.cpp -std=c++17 -pthread
+g++ -O3 -o ../portfolio portfolio.cpp -std=c++17 -pthread
+g++ -O3 -shared -fPIC $(python3-config --includes) -o ../vrp_native$(python3-config --extension-suffix) vrp_native.cpp -std=c++17 -pthread
 cd ..
-chmod +x brute_force nearest_neighbor clarke_wright genetic_algorithm simulated_annealing
\ No newline at end of file
+chmod +x brute_force nearest_neighbor clarke_wright genetic_algorithm simulated_annealing vrp_server vrp_bench vrp_matrix reoptimize vrp_batch decompose portfolio
\ No newline at end of file
@@ -1,5 +1,28 @@
 import subprocess
 import os
+import sys
+import struct
+import json
+import threading
+import itertools
+import importlib
+import sysconfig
+from array import array
+
+# Binary matrix format read by cpp_algorithms/common.h (readBinaryDistanceMatrix)
+MATRIX_FILE_MAGIC = b"VRPM"
+MATRIX_FILE_VERSION = 1
+MATRIX_DTYPE_INT32 = 1
+MATRIX_FLAG_SYMMETRIC = 1
+MATRIX_ALIGNMENT_INTS = 16
+
+# In-process solver module, built from NATIVE_SOURCE next to the binaries
+NATIVE_MODULE = "vrp_native"
+NATIVE_SOURCE = "cpp_algorithms/vrp_native.cpp"
+
+# Disk cache shared by vrp_server, vrp_matrix and vrp_native; an empty VRP_CACHE_DIR turns it off
+CACHE_DIR = os.environ.get("VRP_CACHE_DIR", ".vrp_cache")
+CACHE_MB = os.environ.get("VRP_CACHE_MB", "256")
 
 def ensure_binaries():
     """
@@ -12,7 +35,13 @@ def ensure_binaries():
         "nearest_neighbor": "cpp_algorithms/nearest_neighbor.cpp",
         "clarke_wright": "cpp_algorithms/clarke_wright.cpp",
         "genetic_algorithm": "cpp_algorithms/genetic_algorithm.cpp",
-        "simulated_annealing": "cpp_algorithms/simulated_annealing.cpp"
+        "simulated_annealing": "cpp_algorithms/simulated_annealing.cpp",
+        "vrp_server": "cpp_algorithms/vrp_server.cpp",
+        "vrp_matrix": "cpp_algorithms/vrp_matrix.cpp",
+        "reoptimize": "cpp_algorithms/reoptimize.cpp",
+        "vrp_batch": "cpp_algorithms/vrp_batch.cpp",
+        "decompose": "cpp_algorithms/decompose.cpp",
+        "portfolio": "cpp_algorithms/portfolio.cpp"
     }
     
     for exec_name, source in algos.items():
@@ -21,7 +50,7 @@ def ensure_binaries():
             if os.path.exists(source):
                 try:
                     # Compile using g++ (requires g++ in packages.txt)
-                    subprocess.run(["g++", "-O3", source, "-o", exec_name], check=True)
+                    subprocess.run(["g++", "-O3", "-std=c++17", "-pthread", source, "-o", exec_name], check=True)
                     # Grant execution permissions for the Linux environment
                     os.chmod(exec_name, 0o755)
                 except subprocess.CalledProcessError as e:
@@ -29,12 +58,82 @@ def ensure_binaries():
             else:
                 print(f"Source file {source} not found.")
 
+    # In-process module (see load_native); needs the Python headers
+    native = NATIVE_MODULE + sysconfig.get_config_var("EXT_SUFFIX")
+    if not os.path.exists(native) and os.path.exists(NATIVE_SOURCE):
+        try:
+            subprocess.run(["g++", "-O3", "-std=c++17", "-pthread", "-shared", "-fPIC",
+                            "-I" + sysconfig.get_paths()["include"], NATIVE_SOURCE, "-o", native], check=True)
+        except subprocess.CalledProcessError as e:
+            print(f"Error compiling {NATIVE_SOURCE}: {e}")
+
+_native = None
+_native_checked = False
+
+def load_native():
+    """
+    Returns the vrp_native extension module built by ensure_binaries, or None
+    when it is not available (callers then go through the vrp_server daemon).
+    """
+    global _native, _native_checked
+    if not _native_checked:
+        _native_checked = True
+        directory = os.path.dirname(os.path.abspath(__file__))
+        if directory not in sys.path:
+            sys.path.insert(0, directory)
+        try:
+            _native = importlib.import_module(NATIVE_MODULE)
+        except ImportError:
+            _native = None
+    return _native
+
+def matrix_buffer(matrix):
+    """
+    The (N+1) x (N+1) matrix vrp_native reads. Objects with the buffer
+    protocol (NumPy arrays, array.array) are passed as they are, without a
+    copy; the N x (N+1) lists from get_distance_matrix (depot column first)
+    are expanded into a flat int array with the depot as row 0.
+    """
+    if not isinstance(matrix, (list, tuple)):
+        return matrix
+    n = len(matrix)
+    if n > 0 and len(matrix[0]) == n:
+        return array("i", itertools.chain.from_iterable(matrix))
+    data = array("i", [0] + [row[0] for row in matrix])
+    for row in matrix:
+        data.extend(row)
+    return data
+
 def save_matrix(matrix, filename="input.txt"):
     with open(filename, "w") as f:
         f.write(str(len(matrix)) + "\n")
         for row in matrix:
             f.write(" ".join(map(str, row)) + "\n")
 
+def save_matrix_binary(matrix, filename="input.bin"):
+    """
+    Writes the N x (N+1) matrix as a full (N+1) x (N+1) binary matrix with the
+    depot at index 0, rows padded to 64 bytes so the solvers can mmap it.
+    """
+    n = len(matrix)
+    stride = (n + 1 + MATRIX_ALIGNMENT_INTS - 1) // MATRIX_ALIGNMENT_INTS * MATRIX_ALIGNMENT_INTS
+    padding = [0] * (stride - n - 1)
+
+    symmetric = all(matrix[i][j + 1] == matrix[j][i + 1] for i in range(n) for j in range(i + 1, n))
+    header = struct.pack("<4sIIIII40x", MATRIX_FILE_MAGIC, MATRIX_FILE_VERSION, n,
+                         MATRIX_DTYPE_INT32, MATRIX_FLAG_SYMMETRIC if symmetric else 0, stride)
+
+    data = array("i", [0] + [row[0] for row in matrix] + padding)
+    for row in matrix:
+        data.extend(row)
+        data.extend(padding)
+    if data.itemsize != 4 or struct.pack("=I", 1) != struct.pack("<I", 1):
+        raise RuntimeError("binary matrix format requires little-endian 32-bit ints")
+
+    with open(filename, "wb") as f:
+        f.write(header)
+        data.tofile(f)
+
 def load_output(filename="output.txt"):
     routes = []
     if not os.path.exists(filename):
@@ -45,36 +144,184 @@ def load_output(filename="output.txt"):
             routes.append(route)
     return routes
 
-def solve_vrp(matrix, algo_name):
+# Display names used by app.py -> algorithm names understood by vrp_server
+ALGORITHM_NAMES = {
+    "Brute Force": "brute_force",
+    "Nearest Neighbor": "nearest_neighbor",
+    "Clarke Wright": "clarke_wright",
+    "Genetic Algorithm": "genetic_algorithm",
+    "Simulated Annealing": "simulated_annealing",
+    "Portfolio (race all)": "portfolio"
+}
+
+class SolverDaemon:
+    """
+    One long-running ./vrp_server process shared by every caller.
+    Requests are tagged with a unique id and written to the server's stdin;
+    a reader thread hands each response line to the caller waiting on that id,
+    so concurrent sessions can have solves in flight at the same time.
+    """
+    def __init__(self, executable="./vrp_server", cache_dir=CACHE_DIR):
+        command = [executable]
+        if cache_dir:
+            # Repeated requests are answered from the disk cache
+            command += ["--cache", cache_dir, "--cache-mb", CACHE_MB]
+        self.process = subprocess.Popen(command, stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                        text=True, bufsize=1)
+        self.ids = itertools.count(1)
+        self.waiting = {}
+        self.lock = threading.Lock()
+        self.reader = threading.Thread(target=self._read_responses, daemon=True)
+        self.reader.start()
+
+    def _read_responses(self):
+        for line in self.process.stdout:
+            response = json.loads(line)
+            if "event" in response:
+                # Streamed improvement: the request is still running
+                with self.lock:
+                    slot = self.waiting.get(response.get("id"))
+                if slot is not None and slot["on_event"] is not None:
+                    slot["on_event"](response)
+                continue
+            with self.lock:
+                slot = self.waiting.pop(response.get("id"), None)
+            if slot is not None:
+                slot["response"] = response
+                slot["done"].set()
+        # Server exited: fail everything still waiting
+        with self.lock:
+            for slot in self.waiting.values():
+                slot["response"] = {"error": "vrp_server exited"}
+                slot["done"].set()
+            self.waiting.clear()
+
+    def alive(self):
+        return self.process.poll() is None
+
+    def solve(self, request, on_event=None):
+        slot = {"done": threading.Event(), "response": None, "on_event": on_event}
+        with self.lock:
+            request_id = next(self.ids)
+            self.waiting[request_id] = slot
+            self.process.stdin.write(json.dumps(dict(request, id=request_id)) + "\n")
+            self.process.stdin.flush()
+        slot["done"].wait()
+        response = slot["response"]
+        if "error" in response:
+            raise RuntimeError(response["error"])
+        return response
+
+_daemon = None
+_daemon_lock = threading.Lock()
+
+def get_daemon():
+    global _daemon
+    with _daemon_lock:
+        if _daemon is None or not _daemon.alive():
+            _daemon = SolverDaemon()
+        return _daemon
+
+def add_constraints(request, demands=None, capacity=None, time_windows=None, service_times=None):
+    # Capacity/time window constraints: one entry per node, depot first
+    if demands is not None:
+        request["demands"] = [int(d) for d in demands]
+    if capacity is not None:
+        request["capacity"] = int(capacity)
+    if time_windows is not None:
+        request["time_windows"] = [[int(ready), int(due)] for ready, due in time_windows]
+    if service_times is not None:
+        request["service_times"] = [int(s) for s in service_times]
+
+def solve_vrp(matrix, algo_name, num_vehicles=None, local_search=False, time_limit=None, on_improvement=None,
+              demands=None, capacity=None, time_windows=None, service_times=None, seed=None, with_costs=False,
+              details=None):
+    """
+    Returns the routes as lists of node numbers (0 is the depot, delivery i is
+    node i + 1), or (routes, costs) with the distance of each route when
+    with_costs is set. matrix is the N x (N+1) list from get_distance_matrix
+    or any (N+1) x (N+1) integer buffer such as a NumPy array, which the
+    in-process solver reads without copying. "Portfolio (race all)" races
+    the solvers within time_limit and keeps the best routes any of them
+    finds; a dict passed as details receives the "winner" and each racer's
+    "runs" (the winner is None for a cached portfolio answer).
+    """
     # Step 1: Ensure C++ binaries are compiled for the current environment
     ensure_binaries()
 
-    # Step 2: Map algorithm names to the newly compiled Linux binaries
-    algo_execs = {
-        "Brute Force": "./brute_force",
-        "Nearest Neighbor": "./nearest_neighbor",
-        "Clarke Wright": "./clarke_wright",
-        "Genetic Algorithm": "./genetic_algorithm",
-        "Simulated Annealing": "./simulated_annealing"
+    # Get number of vehicles (num_vehicles.txt is kept for older callers)
+    if num_vehicles is None:
+        num_vehicles = 2
+        if os.path.exists("num_vehicles.txt"):
+            with open("num_vehicles.txt") as f:
+                try:
+                    num_vehicles = int(f.read().strip())
+                except ValueError:
+                    num_vehicles = 2
+
+    if algo_name not in ALGORITHM_NAMES:
+        return ([], []) if with_costs else []
+    if details is None:
+        details = {}
+
+    # Step 2: Solve in this process when the module is built; the GIL is
+    # released while it runs, so other sessions are not blocked
+    native = load_native()
+    if native is not None:
+        routes, costs, race = native.solve(
+            matrix_buffer(matrix), ALGORITHM_NAMES[algo_name], int(num_vehicles),
+            local_search=bool(local_search), time_limit=float(time_limit or 0.0), seed=int(seed or 0),
+            demands=demands, capacity=int(capacity or 0), time_windows=time_windows, service_times=service_times,
+            on_improvement=(lambda routes, distance: on_improvement([list(route) for route in routes], distance))
+            if on_improvement is not None else None,
+            cache_dir=CACHE_DIR or None, cache_mb=float(CACHE_MB), details=True)
+        details.update(race)
+        routes = [list(route) for route in routes]
+        return (routes, list(costs)) if with_costs else routes
+
+    # Otherwise hand the matrix to the shared solver daemon; no files are written
+    if not isinstance(matrix, (list, tuple)):
+        matrix = matrix.tolist()
+    request = {
+        "algorithm": ALGORITHM_NAMES[algo_name],
+        "vehicles": int(num_vehicles),
+        "matrix": matrix,
+        "local_search": bool(local_search)
     }
-    
-    # Get number of vehicles
-    num_vehicles = 2
-    if os.path.exists("num_vehicles.txt"):
-        with open("num_vehicles.txt") as f:
-            try:
-                num_vehicles = int(f.read().strip())
-            except ValueError:
-                num_vehicles = 2
-    
-    # Save input data for the C++ solver
-    save_matrix(matrix)
-    
-    # Run the selected algorithm with num_vehicles as argument
-    if algo_name in algo_execs:
-        cmd = [algo_execs[algo_name], str(num_vehicles)]
-        # Use check=True to catch errors during execution
-        subprocess.run(cmd, stdout=subprocess.PIPE, check=True)
-    
-    # Load and return routes from the output.txt generated by the C++ solver
-    return load_output()
\ No newline at end of file
+    add_constraints(request, demands, capacity, time_windows, service_times)
+    if seed is not None:
+        request["seed"] = int(seed)
+    # Anytime solving: stop at time_limit seconds, pass each new best to on_improvement
+    if time_limit is not None:
+        request["time_limit_ms"] = float(time_limit) * 1000.0
+    on_event = None
+    if on_improvement is not None:
+        request["stream"] = True
+        on_event = lambda event: on_improvement(event["routes"], event["distance"])
+    response = get_daemon().solve(request, on_event)
+    fallback = None if request["algorithm"] == "portfolio" else request["algorithm"]
+    details.update(winner=response.get("winner", fallback), runs=response.get("runs", []))
+    return (response["routes"], response["route_distances"]) if with_costs else response["routes"]
+
+def reoptimize_vrp(matrix, previous_routes, added=(), removed=(), num_vehicles=None, local_search=True,
+                   time_limit=None, demands=None, capacity=None, time_windows=None, service_times=None):
+    """
+    Warm start after orders change mid-day: keeps previous_routes, drops the
+    removed stops, inserts the added ones and improves only around the change.
+    Stops are node numbers in matrix (delivery i is node i + 1); num_vehicles
+    None keeps the fleet.
+    """
+    ensure_binaries()
+    request = {
+        "previous_routes": [[int(node) for node in route] for route in previous_routes],
+        "added": [int(node) for node in added],
+        "removed": [int(node) for node in removed],
+        "matrix": matrix,
+        "local_search": bool(local_search)
+    }
+    if num_vehicles is not None:
+        request["vehicles"] = int(num_vehicles)
+    add_constraints(request, demands, capacity, time_windows, service_times)
+    if time_limit is not None:
+        request["time_limit_ms"] = float(time_limit) * 1000.0
+    return get_daemon().solve(request)["routes"]